@@ -7,6 +7,11 @@ Key behaviors:
   automatically tries equivalent devices on WASAPI/DirectSound/MME.
 - Silence stability: tracks a noise floor and subtracts it before auto-gain, so
   silence does not normalize to a high motion value.
+- Low latency (native/ built, power-of-two buffer_size): the callback pushes small hops into
+  a lock-free ring and features come from the newest buffer_size samples, computed in C++.
+- Beat events: onsets are detected on the unsmoothed energy and reported as beat_id (counts
+  up per onset), beat_strength (0-1) and beat_ms (time.monotonic() ms), so the firmware can
+  render the flash itself instead of waiting for the EMA.
 """
 
 import time
@@ -16,6 +21,11 @@ import numpy as np
 import scipy.fftpack
 import sounddevice as sd
 
+try:
+    from native import ext as native_ext
+except ImportError:
+    native_ext = None
+
 
 class AudioFFT:
     def __init__(self, sample_rate=44100, buffer_size=2048, ema_ms=100, device=None):
@@ -60,6 +70,7 @@ class AudioFFT:
 
         # Config-driven thresholds
         from config import Config
+        from signal_processing import OnsetDetector
 
         cfg = Config()
         self.target_level = float(cfg.audio_target_level)
@@ -68,6 +79,24 @@ class AudioFFT:
         self.noise_gate_hold = float(cfg.audio_noise_gate_hold_s)
         self._release_ms = float(cfg.audio_release_ms)
 
+        # Beat events (raw energy, before the attack/release EMA)
+        self._beats_enabled = bool(cfg.enable_audio_beats)
+        self._onset_args = (cfg.audio_onset_threshold, cfg.audio_onset_min_flux,
+                            cfg.audio_onset_refractory_ms, 400.0, self.target_level)
+        self._onsets = OnsetDetector(*self._onset_args)
+        self.beat_id = 0
+        self.beat_strength = 0.0
+        self.beat_ms = None
+
+        # Native tap (sounddevice backend only): the callback writes audio_hop_size blocks
+        # into the ring, get_audio_features() analyzes the newest buffer_size samples.
+        n = self.buffer_size
+        self._use_tap = bool(cfg.audio_use_native) and native_ext is not None and n >= 64 and (n & (n - 1)) == 0
+        self._fft_hann = bool(cfg.audio_fft_hann)
+        self.hop_size = int(cfg.audio_hop_size) if self._use_tap else self.buffer_size
+        self._tap = None
+        self._tap_features = None
+
         self._last_active_time = time.time()
         self._last_init_attempt_time = 0.0
 
@@ -99,6 +128,15 @@ class AudioFFT:
         self._last_active_time = now
         self._latest_audio = None
         self._latest_audio_time = 0.0
+        self._tap_features = None
+        self._onsets = OnsetDetector(*self._onset_args)
+
+    @property
+    def poll_interval_s(self):
+        """How often get_audio_features() has new audio: one hop with the native tap."""
+        if self._tap is not None:
+            return min(self.hop_size / self.sample_rate, 0.04)
+        return 0.04
 
     def close(self):
         try:
@@ -133,7 +171,11 @@ class AudioFFT:
 
     def _audio_callback(self, indata, frames, time_info, status):
         try:
-            self._latest_audio = np.array(indata, copy=True)
+            tap = self._tap
+            if tap is not None:
+                tap.write(indata)  # no copy or allocation on the audio thread
+            else:
+                self._latest_audio = np.array(indata, copy=True)
             self._latest_audio_time = time.time()
         except Exception:
             pass
@@ -304,6 +346,9 @@ class AudioFFT:
                 default_sr = float(info.get("default_samplerate", desired_sr) or desired_sr)
 
                 def _try_open(sr, bs):
+                    # Fresh ring per stream; bins follow the sample rate actually opened.
+                    self._tap = native_ext.AudioTap(self.buffer_size, sr, self._fft_hann) if self._use_tap else None
+                    self._tap_features = None
                     self.stream = sd.InputStream(
                         samplerate=sr,
                         channels=channels,
@@ -316,8 +361,8 @@ class AudioFFT:
                     self.stream.start()
 
                 attempts = [
-                    (desired_sr, int(self.buffer_size)),
-                    (default_sr, int(self.buffer_size)),
+                    (desired_sr, int(self.hop_size)),
+                    (default_sr, int(self.hop_size)),
                     (default_sr, 0),
                     (desired_sr, 0),
                 ]
@@ -550,8 +595,10 @@ class AudioFFT:
                     if self.stream is None and self._backend != 'soundcard':
                         return {"energy": 0.0, "bass": 0.0, "mid": 0.0, "centroid": 0.0}
 
-                audio = self._latest_audio
-                if audio is None:
+                tap = self._tap
+                audio = None if tap is not None else self._latest_audio
+                no_data = tap.written == 0 if tap is not None else audio is None
+                if no_data:
                     # No callback data yet; try switching to loopback if this looks like a Stereo Mix/WDM-KS selection.
                     if self._prefer_soundcard_loopback and self._try_init_soundcard_loopback():
                         self._reset_signal_tracking()
@@ -570,17 +617,28 @@ class AudioFFT:
                         pass
                     return {"energy": 0.0, "bass": 0.0, "mid": 0.0, "centroid": 0.0}
 
-            mono = np.mean(audio, axis=1)
-            n = int(len(mono))
-            if n < 64:
-                return {"energy": 0.0, "bass": 0.0, "mid": 0.0, "centroid": 0.0}
+            if audio is None:
+                result = tap.analyze()
+                if result is None:
+                    return {"energy": 0.0, "bass": 0.0, "mid": 0.0, "centroid": 0.0}
+                low, mid, centroid, fresh = result
+                if fresh == 0 and self._tap_features is not None:
+                    # Polled faster than the hop size: nothing new to fold into the envelope.
+                    return dict(self._tap_features)
+                # The envelope advances by the samples that arrived, not by the window.
+                n = int(min(fresh, self.buffer_size))
+            else:
+                mono = np.mean(audio, axis=1)
+                n = int(len(mono))
+                if n < 64:
+                    return {"energy": 0.0, "bass": 0.0, "mid": 0.0, "centroid": 0.0}
 
-            fft = np.abs(scipy.fftpack.fft(mono))[: n // 2]
-            freqs = np.fft.fftfreq(n, 1 / self.sample_rate)[: n // 2]
+                fft = np.abs(scipy.fftpack.fft(mono))[: n // 2]
+                freqs = np.fft.fftfreq(n, 1 / self.sample_rate)[: n // 2]
 
-            low = float(np.sum(fft[(freqs >= 20) & (freqs < 150)]))
-            mid = float(np.sum(fft[(freqs >= 150) & (freqs < 2000)]))
-            centroid = self._compute_centroid(freqs, fft)
+                low = float(np.sum(fft[(freqs >= 20) & (freqs < 150)]))
+                mid = float(np.sum(fft[(freqs >= 150) & (freqs < 2000)]))
+                centroid = self._compute_centroid(freqs, fft)
 
             energy_raw = 0.7 * low + 0.3 * mid
 
@@ -611,17 +669,31 @@ class AudioFFT:
             elif now - self._last_active_time > self.noise_gate_hold:
                 energy = 0.0
 
+            if self._beats_enabled:
+                now_ms = time.monotonic() * 1000.0
+                strength = self._onsets.update(energy, 1000.0 * n / self.sample_rate, now_ms)
+                if strength is not None:
+                    self.beat_id = (self.beat_id + 1) & 0xFF
+                    self.beat_strength = float(strength)
+                    self.beat_ms = now_ms
+
             attack_alpha = self._compute_ema_alpha_for_frame(self.ema_ms, n)
             release_alpha = self._compute_ema_alpha_for_frame(self._release_ms, n)
             energy_slow = attack_alpha * energy + (1 - attack_alpha) * self.last_energy
             self.last_energy = energy_slow if energy > self.last_energy else release_alpha * energy + (1 - release_alpha) * self.last_energy
 
-            return {
+            features = {
                 "energy": float(self.last_energy),
                 "bass": low,
                 "mid": mid,
                 "centroid": float(centroid),
+                "beat_id": self.beat_id,
+                "beat_strength": self.beat_strength,
+                "beat_ms": self.beat_ms,
             }
+            if audio is None:
+                self._tap_features = features
+            return features
 
         except Exception as e:
             print(f"[AUDIO] Audio FFT failed: {e}")
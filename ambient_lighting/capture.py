@@ -0,0 +1,52 @@
+"""
+capture.py
+ALCAP1 packet captures for deterministic replay (firmware/host/replay).
+
+File layout (little-endian):
+  b"ALCAP1\\0\\0"
+  records: [u32 t_ms][u8 channel][u16 len][len bytes]
+t_ms is relative to the start of the capture: send time when written by UDPSender, ESP32
+arrival time when written by tools/capture_device.py.
+"""
+import struct
+import time
+
+CAPTURE_MAGIC = b'ALCAP1\x00\x00'
+CHANNEL_CONTROL = 0  # UDP_PORT datagrams (v1/v2 packets)
+CHANNEL_DDP = 1      # raw pixel stream datagrams
+_RECORD = struct.Struct('<IBH')
+
+
+class CaptureWriter:
+    def __init__(self, path):
+        self._f = open(path, 'wb')
+        self._f.write(CAPTURE_MAGIC)
+        self._t0 = time.monotonic()
+
+    def write(self, data, t_ms=None, channel=CHANNEL_CONTROL):
+        if t_ms is None:
+            t_ms = int((time.monotonic() - self._t0) * 1000.0)
+        data = bytes(data)
+        self._f.write(_RECORD.pack(int(t_ms) & 0xFFFFFFFF, channel, len(data)))
+        self._f.write(data)
+
+    def close(self):
+        self._f.close()
+
+
+def read_capture(path):
+    """Yield (t_ms, channel, data) for every record in a capture."""
+    with open(path, 'rb') as f:
+        if f.read(len(CAPTURE_MAGIC)) != CAPTURE_MAGIC:
+            raise ValueError(f"{path}: not an ALCAP1 capture")
+        while True:
+            hdr = f.read(_RECORD.size)
+            if not hdr:
+                return
+            if len(hdr) < _RECORD.size:
+                raise ValueError(f"{path}: truncated record")
+            t_ms, channel, length = _RECORD.unpack(hdr)
+            data = f.read(length)
+            if len(data) < length:
+                raise ValueError(f"{path}: truncated record")
+            yield t_ms, channel, data
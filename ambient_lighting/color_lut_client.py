@@ -0,0 +1,67 @@
+"""
+color_lut_client.py
+Builds and uploads per-segment gamma/white-balance LUTs (control command 0x03).
+Layout must match firmware/main/protocol.h and color_lut.h.
+"""
+import socket
+import struct
+
+from packet_builder import crc16_ccitt
+
+CONTROL_MAGIC = 0xA6
+CONTROL_REPLY = 0x80
+CONTROL_CMD_COLOR_LUT = 0x03
+CONTROL_LUT_PERSIST = 0x01
+CONTROL_LUT_DEFAULT = 0x02
+
+LUT_OK, LUT_BAD, LUT_BUSY = 0, 1, 2
+COLOR_LUT_BYTES = 3 * 256
+
+
+def build_lut(gamma=2.2, white=(255, 255, 255)):
+    """R, G and B tables (256 entries each): white[c] * (v / 255) ** gamma, rounded."""
+    table = bytearray(COLOR_LUT_BYTES)
+    for c in range(3):
+        for v in range(256):
+            table[c * 256 + v] = int(white[c] * (v / 255.0) ** gamma + 0.5)
+    return bytes(table)
+
+
+def build_lut_request(segment, table=None, persist=False):
+    """Upload `table` to `segment`, or restore the built-in table when `table` is None."""
+    flags = CONTROL_LUT_PERSIST if persist else 0
+    if table is None:
+        flags |= CONTROL_LUT_DEFAULT
+        table = b''
+    elif len(table) != COLOR_LUT_BYTES:
+        raise ValueError('color LUT must be %d bytes' % COLOR_LUT_BYTES)
+    body = bytes([CONTROL_MAGIC, CONTROL_CMD_COLOR_LUT, flags, segment]) + bytes(table)
+    return body + struct.pack('<H', crc16_ccitt(body))
+
+
+def parse_lut_reply(data):
+    """Return the status byte of a LUT reply, or None if it is not one."""
+    if len(data) != 3 or data[0] != CONTROL_MAGIC or data[1] != (CONTROL_CMD_COLOR_LUT | CONTROL_REPLY):
+        return None
+    return data[2]
+
+
+def upload_lut(ip, port, segment, table=None, persist=False, timeout=0.5, retries=3):
+    """Send one LUT request, retrying while the device reports busy. Returns the status or None."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        sock.settimeout(timeout)
+        request = build_lut_request(segment, table, persist)
+        status = None
+        for _ in range(retries):
+            sock.sendto(request, (ip, port))
+            try:
+                data, _ = sock.recvfrom(64)
+            except socket.timeout:
+                continue
+            status = parse_lut_reply(data)
+            if status != LUT_BUSY:
+                break
+        return status
+    finally:
+        sock.close()
@@ -8,18 +8,60 @@ class Config:
     def __init__(self):
         # UDP settings
         self.udp_ip = '192.168.0.100'  # ESP32 IP (updated to match device)
+        # Several ESP32s: set udp_ip to the firmware's UDP_MULTICAST_GROUP ('239.10.42.1') or
+        # the subnet broadcast address, so each frame is sent once for every unit.
+        self.udp_multicast_ttl = 1
         self.udp_port = 4210
         self.udp_rate_hz = 25
+        # Send control packets from the native pacer thread (build native/setup.py) on exact
+        # 1/udp_rate_hz deadlines; packets are built udp_pacer_lead_ms ahead of each one.
+        self.udp_native_pacer = True
+        self.udp_pacer_lead_ms = 8
+        # Adaptive rate (rate_controller.py): up to udp_max_rate_hz while the scene changes,
+        # udp_keepalive_hz when it is static (capped at 1 s, under the 1.8 s fallback). An input
+        # move of udp_rate_full_delta color/energy units asks for the maximum rate.
+        self.udp_adaptive_rate = True
+        self.udp_max_rate_hz = 60
+        self.udp_keepalive_hz = 2
+        self.udp_rate_full_delta = 8
+        # 1 = legacy 12-byte packet; 2 = timestamped v2 (16-bit seq, sender clock, CRC16).
+        # v2 needs firmware with protocol v2 support; it still accepts v1.
+        self.udp_protocol_version = 1
+        # v2 only: every unit shows a frame this many ms (1-255) after its sender timestamp, so
+        # walls fed the same stream stay in step. 0 = each unit's own adaptive jitter delay.
+        # Cover the worst delivery delay; multicast over Wi-Fi is slower than unicast.
+        self.sync_present_delay_ms = 0
+        # Raw pixel streaming (DDP): laptop-rendered frames, see PacketBuilder.build_raw_frame
+        self.ddp_port = 4048
         self.debug_udp_packets = False
+        # Record every sent datagram to this ALCAP1 file (None = off); replay with firmware/host
+        self.capture_path = None
         # Screen settings
         self.screen_downscale = (64, 36)
         self.screen_crop_top = 0.07
         self.screen_crop_bottom = 0.13
         self.screen_ema_ms = 600
+        # Sample with the native kernel (build native/setup.py); falls back to OpenCV if absent
+        self.screen_use_native = True
         # Audio settings
         self.audio_sample_rate = 44100
         self.audio_buffer_size = 2048
         self.audio_ema_ms = 100
+        # Native audio ring (build native/setup.py): the callback delivers audio_hop_size
+        # blocks and features use the newest audio_buffer_size samples, so lights lag about
+        # one hop instead of one full buffer. Needs a power-of-two audio_buffer_size.
+        self.audio_use_native = True
+        self.audio_hop_size = 512
+        self.audio_fft_hann = False  # rectangular, like the numpy path the gains were tuned on
+        # Beat events (protocol v2, modes 2/3): onsets in the raw audio energy go out as a
+        # [beat id][strength][age] extension and the ESP32 renders the attack/decay flash itself.
+        # An onset is a rise of more than threshold x the running mean rise + min_flux (energy
+        # units, ~0-190), at most one per refractory_ms. Off by default, like the other v2
+        # extensions: turn it on together with udp_protocol_version = 2.
+        self.enable_audio_beats = False
+        self.audio_onset_threshold = 1.6
+        self.audio_onset_min_flux = 8.0
+        self.audio_onset_refractory_ms = 120
         # LED settings
         self.led_count = 600
         # 0-255 (uint8). Set to 255 for maximum output; ESP32 FastLED power limiting still applies.
@@ -61,6 +103,10 @@ class Config:
         self.enable_spatial_bias = True
         self.spatial_regions = 3  # left, center, right
         self.spatial_bias_blend = 0.35  # blend dominant region color into base
+        # Per-zone color (protocol v2 only): send N column colors instead of one mean color.
+        # 0 = off. The ESP32 blends neighbouring zones along the strip.
+        self.zone_count = 0  # e.g. 8-32
+        self.zone_reverse = False  # True if LED 0 sits at the right edge of the screen
         # Audio robustness
         self.audio_target_level = 160  # normalize toward this
         self.audio_hard_cap = 190      # hard ceiling
@@ -108,3 +154,22 @@ class Config:
 
         # Mode 4 static color override (bright amber)
         self.mode4_static_color = [255, 180, 80]
+
+    def validate(self):
+        """
+        Return a warning string for each setting that cannot take effect as configured.
+        Beats, zones and sync ride on v2 extensions, which a v1 packet silently drops.
+        """
+        warnings = []
+        if int(self.udp_protocol_version) < 2:
+            v2_only = []
+            if self.enable_audio_beats:
+                v2_only.append('enable_audio_beats')
+            if int(self.zone_count) > 0:
+                v2_only.append('zone_count')
+            if int(self.sync_present_delay_ms) > 0:
+                v2_only.append('sync_present_delay_ms')
+            for name in v2_only:
+                warnings.append(f"{name} needs udp_protocol_version = 2; "
+                                f"protocol {self.udp_protocol_version} packets do not carry it")
+        return warnings
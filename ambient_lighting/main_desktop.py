@@ -14,6 +14,7 @@ from PyQt5 import QtWidgets, QtGui, QtCore
 from config import Config
 from mode_manager import ModeManager
 from udp_sender import UDPSender
+from rate_controller import RateController
 from screen.screen_sampler import ScreenSampler
 from audio.audio_fft import AudioFFT
 
@@ -27,6 +28,10 @@ data = {
     'audio_bass': 0.0,
     'audio_mid': 0.0,
     'audio_centroid': 0.0,
+    # Latest audio onset: id (counts up, wraps at 256), strength 0-1, time.monotonic() ms
+    'audio_beat_id': 0,
+    'audio_beat_strength': 0.0,
+    'audio_beat_ms': None,
     'motion_energy': 0.0,
     'motion_speed': 0.15,
     # Direction hint encoded as ~32 (left), 128 (center/neutral), ~224 (right)
@@ -235,6 +240,7 @@ class MainWindow(QtWidgets.QWidget):
             audio_backend = data.get('audio_backend', '')
             audio_source = data.get('audio_source', '')
             audio_rms = data.get('audio_rms', 0.0)
+            udp_stats = data.get('udp_stats')
             error_msg = data.get('error_msg', "")
         qcolor = QtGui.QColor(*rgb)
         pix = QtGui.QPixmap(60, 60)
@@ -251,6 +257,12 @@ class MainWindow(QtWidgets.QWidget):
             self.status_label.setText(
                 f"Mode: {mode} | Color: {rgb} | Motion: {motion:.2f} | Audio: {audio_motion:.2f} | Dev: {audio_dev}"
             )
+        if udp_stats:
+            # Pacer health: slots with no fresh packet and the worst wake-up lateness.
+            self.status_label.setText(
+                self.status_label.text()
+                + f" | UDP: {udp_stats['sent']} sent, {udp_stats['idle']} idle, late {udp_stats['max_late_ms']:.1f} ms"
+            )
         self.motion_graph.update_value(motion)
         self.error_label.setText(error_msg)
 
@@ -269,6 +281,7 @@ def screen_thread():
             dark_boost=cfg.enable_dark_boost,
             dark_boost_v_thresh=cfg.dark_boost_v_thresh,
             dark_boost_strength=cfg.dark_boost_strength,
+            use_native=cfg.screen_use_native,
         )
     except Exception as e:
         msg = f"ScreenSampler init failed: {e}"
@@ -291,8 +304,9 @@ def screen_thread():
             with data_lock:
                 current_mode = data.get('mode', 1)
 
+            zones = int(getattr(cfg, 'zone_count', 0)) if current_mode != 2 else 0
             if cfg.enable_spatial_bias and current_mode != 2:
-                color, region_colors, region_weights = sampler.get_screen_data(regions=cfg.spatial_regions)
+                color, region_colors, region_weights = sampler.get_screen_data(regions=cfg.spatial_regions, zones=zones)
                 # pick dominant region by weight
                 if region_weights and max(region_weights) > 0:
                     idx = int(np.argmax(region_weights))
@@ -318,8 +332,13 @@ def screen_thread():
                 else:
                     direction = 128
             else:
-                color = sampler.get_screen_color()
+                color = sampler.get_screen_color(zones=zones)
                 direction = 128
+            zone_colors = None
+            if zones > 0 and sampler.last_zone_colors is not None:
+                zone_colors = sampler.last_zone_colors.copy()
+                if cfg.zone_reverse:
+                    zone_colors = zone_colors[::-1]
             delta = np.abs(color - last_color).sum()
             screen_motion = np.clip(delta * 0.8, 0, 180)
             motion_value = motion_alpha * screen_motion + (1 - motion_alpha) * motion_value
@@ -327,6 +346,7 @@ def screen_thread():
             with data_lock:
                 if current_mode != 2:  # Mode 2 color comes from audio downstream
                     data['base_color'] = color
+                data['zone_colors'] = zone_colors
                 data['screen_motion_energy'] = motion_value
                 data['direction'] = direction
                 data['error_msg'] = ""
@@ -382,6 +402,10 @@ def audio_thread():
                 data['audio_bass'] = features.get('bass', 0.0)
                 data['audio_mid'] = features.get('mid', 0.0)
                 data['audio_centroid'] = features.get('centroid', 0.0)
+                if 'beat_id' in features:
+                    data['audio_beat_id'] = features['beat_id']
+                    data['audio_beat_strength'] = features['beat_strength']
+                    data['audio_beat_ms'] = features['beat_ms']
 
                 # Telemetry for debugging intermittent Mode 2 failures.
                 data['audio_backend'] = getattr(audio_fft, '_backend', '') or ''
@@ -403,26 +427,77 @@ def audio_thread():
                 data['error_msg'] = msg
             last_error = msg
             audio_fft = None  # force re-init on next loop
-        time.sleep(0.04)
+        # Poll once per audio hop so onsets are stamped close to when they happened.
+        time.sleep(getattr(audio_fft, 'poll_interval_s', 0.04))
+
+
+def paced_udp_loop(config, mode_manager, udp_sender, rate):
+    """Build each packet just ahead of the pacer's next deadline, stamped with that deadline.
+    The native thread sends it on time even when this thread is held up by the GIL or the GUI.
+    Slots the rate controller skips stay empty (the pacer counts them as idle)."""
+    pacer = udp_sender.pacer
+    lead_s = config.udp_pacer_lead_ms / 1000.0
+    built_for = None
+    last_stats = 0.0
+    while True:
+        deadline_ms, wait_s = pacer.next_slot()
+        if deadline_ms == built_for:
+            time.sleep(max(wait_s, 0.0) + 0.001)  # this slot is filled; wait for it to go out
+            continue
+        if wait_s > lead_s:
+            time.sleep(wait_s - lead_s)
+        try:
+            built_for = deadline_ms
+            packet = None
+            with data_lock:
+                slot_time = time.monotonic() + max(wait_s, 0.0)
+                if rate.due(data, slot_time):
+                    rate.start_packet(data, slot_time)
+                    mode_manager.update_mode(data)
+                    packet = mode_manager.build_packet(data, sender_ms=deadline_ms)
+            if packet is not None:
+                udp_sender.send(packet)
+        except Exception as e:
+            msg = f"UDP thread error: {e}"
+            print(msg)
+            with data_lock:
+                data['error_msg'] = msg
+            time.sleep(0.2)
+        now = time.time()
+        if now - last_stats > 1.0:
+            last_stats = now
+            stats = pacer.stats()
+            with data_lock:
+                data['udp_stats'] = stats
 
 
 def udp_thread():
     config = Config()
     mode_manager = ModeManager(config)
     udp_sender = UDPSender(config)
+    rate = RateController(config)
+    if config.udp_native_pacer and udp_sender.start_pacer(rate.send_rate_hz):
+        print(f"[UDP] Native pacer at {rate.send_rate_hz:g} Hz")
+        paced_udp_loop(config, mode_manager, udp_sender, rate)
+        return
     while True:
         try:
+            packet = None
             with data_lock:
-                mode_manager.update_mode(data)
-                packet = mode_manager.build_packet(data)
-            udp_sender.send(packet)
+                now = time.monotonic()
+                if rate.due(data, now):
+                    rate.start_packet(data, now)
+                    mode_manager.update_mode(data)
+                    packet = mode_manager.build_packet(data)
+            if packet is not None:
+                udp_sender.send(packet)
         except Exception as e:
             msg = f"UDP thread error: {e}"
             print(msg)
             with data_lock:
                 data['error_msg'] = msg
             time.sleep(0.2)
-        time.sleep(0.04)
+        time.sleep(rate.poll_interval_s)
 
 
 def main():
@@ -27,6 +27,7 @@ class ModeManager:
         self.last_audio_color = np.array([180, 160, 140], dtype=np.float32)
         self._last_motion_speed = 0.15
         self._frame_id = 0
+        self._seq = 0
         self._last_brightness = None
 
     def update_mode(self, data):
@@ -75,12 +76,19 @@ class ModeManager:
         self.last_audio_color = c
         return c
 
-    def build_packet(self, data):
+    def build_packet(self, data, sender_ms=None):
+        """sender_ms: timestamp the packet with this send time (UDPSender pacer deadline) instead of now."""
         self.last_packet_time = time.time()
 
         # Packet sequence number (byte 9). Increment once per send.
         data['frame_id'] = int(self._frame_id) & 0xFF
         self._frame_id = (self._frame_id + 1) & 0xFF
+        # Protocol v2: 16-bit sequence and sender clock (ms) so the ESP32 can time keyframes.
+        data['seq'] = int(self._seq) & 0xFFFF
+        self._seq = (self._seq + 1) & 0xFFFF
+        if sender_ms is None:
+            sender_ms = time.monotonic() * 1000.0
+        data['sender_ms'] = int(sender_ms) & 0xFFFFFFFF
 
         mode = data.get('mode', 1)
 
@@ -122,6 +130,20 @@ class ModeManager:
         if mode == 2:
             data['base_color'] = self._audio_color(data)
 
+        # Per-zone colors follow the screen, so only the screen-colored modes carry them.
+        zone_colors = data.get('zone_colors')
+        if mode in (1, 3) and int(getattr(self.config, 'zone_count', 0)) > 0 and zone_colors is not None:
+            data['zones'] = zone_colors
+        else:
+            data['zones'] = None
+
+        # Beat events ride along in the audio modes; the ESP32 renders the envelope itself.
+        beat_ms = data.get('audio_beat_ms')
+        if mode in (2, 3) and getattr(self.config, 'enable_audio_beats', False) and beat_ms is not None:
+            data['beat'] = (int(data.get('audio_beat_id', 0)), float(data.get('audio_beat_strength', 0.0)), beat_ms)
+        else:
+            data['beat'] = None
+
         # Quantize motion energy once and use the same value for packet + speed mapping.
         motion_energy_q = int(np.clip(np.round(float(motion_energy)), 0, 180))
         data['motion_energy'] = motion_energy_q
@@ -0,0 +1,18 @@
+"""
+native
+Optional C++ kernels for the laptop app (build with native/setup.py). Callers keep their
+numpy/OpenCV path and use these only when `ext` is not None.
+"""
+
+try:
+    from . import _ambient_native as ext
+except ImportError:
+    ext = None
+
+# float64 values per downscaled column from ext.sample_columns() (see sampler_kernel.h)
+SAMPLE_FIELDS = 8
+
+
+def simd():
+    """Instruction set of the loaded kernels, or None when the module is not built."""
+    return ext.simd() if ext is not None else None
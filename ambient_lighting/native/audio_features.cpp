@@ -0,0 +1,74 @@
+// audio_features.cpp
+// FFT band energies and spectral centroid for AudioFFT.get_audio_features()
+#include "audio_features.h"
+#include <cmath>
+
+static const double kPi = 3.14159265358979323846;
+
+// First bin whose frequency is >= hz (same float64 bin frequencies as np.fft.fftfreq).
+static int firstBinAtOrAbove(double hz, double binHz, int bins) {
+    int k = 0;
+    while (k < bins && k * binHz < hz) ++k;
+    return k;
+}
+
+AudioAnalyzer::AudioAnalyzer(int n, double sampleRate, bool hann)
+    : n_(n), binHz_(sampleRate / n), window_(n), cosTable_(n / 2), sinTable_(n / 2), bitrev_(n), re_(n),
+      im_(n) {
+    for (int i = 0; i < n; ++i) window_[i] = hann ? 0.5 - 0.5 * std::cos(2.0 * kPi * i / n) : 1.0;
+    for (int i = 0; i < n / 2; ++i) {
+        cosTable_[i] = std::cos(2.0 * kPi * i / n);
+        sinTable_[i] = -std::sin(2.0 * kPi * i / n);
+    }
+    int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        bitrev_[i] = r;
+    }
+    const int bins = n / 2;
+    lowBegin_ = firstBinAtOrAbove(20.0, binHz_, bins);
+    lowEnd_ = firstBinAtOrAbove(150.0, binHz_, bins);
+    midBegin_ = lowEnd_;
+    midEnd_ = firstBinAtOrAbove(2000.0, binHz_, bins);
+}
+
+AudioFeatures AudioAnalyzer::analyze(const float *samples) {
+    const int n = n_;
+    for (int i = 0; i < n; ++i) {
+        re_[bitrev_[i]] = samples[i] * window_[i];
+        im_[bitrev_[i]] = 0.0;
+    }
+    // Iterative radix-2 decimation in time.
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len >> 1;
+        const int step = n / len;
+        for (int base = 0; base < n; base += len) {
+            for (int j = 0; j < half; ++j) {
+                const double wr = cosTable_[j * step];
+                const double wi = sinTable_[j * step];
+                const int a = base + j;
+                const int b = a + half;
+                const double tr = re_[b] * wr - im_[b] * wi;
+                const double ti = re_[b] * wi + im_[b] * wr;
+                re_[b] = re_[a] - tr;
+                im_[b] = im_[a] - ti;
+                re_[a] += tr;
+                im_[a] += ti;
+            }
+        }
+    }
+
+    AudioFeatures f = {0.0, 0.0, 0.0};
+    double magSum = 0.0, weighted = 0.0;
+    for (int k = 0; k < n / 2; ++k) {
+        const double mag = std::sqrt(re_[k] * re_[k] + im_[k] * im_[k]);
+        magSum += mag;
+        weighted += k * binHz_ * mag;
+        if (k >= lowBegin_ && k < lowEnd_) f.low += mag;
+        else if (k >= midBegin_ && k < midEnd_) f.mid += mag;
+    }
+    f.centroid = weighted / (magSum + 1e-9);
+    return f;
+}
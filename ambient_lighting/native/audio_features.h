@@ -0,0 +1,30 @@
+// audio_features.h
+// FFT band energies and spectral centroid for AudioFFT.get_audio_features()
+#pragma once
+#include <vector>
+
+struct AudioFeatures {
+    double low;      // sum of |X(f)| for 20 <= f < 150 Hz
+    double mid;      // sum of |X(f)| for 150 <= f < 2000 Hz
+    double centroid; // magnitude-weighted mean frequency over [0, sampleRate / 2)
+};
+
+// Same quantities as the numpy path (|fft| of the mono window, bins below Nyquist), with the
+// window, twiddles and bit-reversal order computed once. analyze() does not allocate.
+class AudioAnalyzer {
+public:
+    // `n` must be a power of two (>= 64). `hann` applies a Hann window, otherwise rectangular.
+    AudioAnalyzer(int n, double sampleRate, bool hann);
+
+    AudioFeatures analyze(const float *samples);
+    int size() const { return n_; }
+
+private:
+    int n_;
+    double binHz_;
+    std::vector<double> window_;
+    std::vector<double> cosTable_, sinTable_; // n / 2 twiddles
+    std::vector<int> bitrev_;
+    std::vector<double> re_, im_;
+    int lowBegin_, lowEnd_, midBegin_, midEnd_; // bin ranges [begin, end)
+};
@@ -0,0 +1,39 @@
+// audio_ring.cpp
+// Single-producer/single-consumer sample ring between the audio callback and feature extraction
+#include "audio_ring.h"
+
+AudioRing::AudioRing(size_t capacity) : mask_(0), head_(0) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    buf_.assign(size, 0.0f);
+    mask_ = size - 1;
+}
+
+void AudioRing::write(const float *interleaved, size_t frames, int channels) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    const float scale = 1.0f / float(channels);
+    for (size_t i = 0; i < frames; ++i, ++head) {
+        const float *frame = interleaved + i * size_t(channels);
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) sum += frame[c];
+        buf_[size_t(head) & mask_] = channels == 1 ? sum : sum * scale;
+    }
+    head_.store(head, std::memory_order_release); // publishes the samples above
+}
+
+bool AudioRing::readLatest(float *out, size_t n, uint64_t *writtenAt) const {
+    if (n == 0 || n > buf_.size()) return false;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        if (head < n) return false;
+        const uint64_t start = head - n;
+        for (size_t i = 0; i < n; ++i) out[i] = buf_[size_t(start + i) & mask_];
+        // Seqlock-style check: valid unless the producer wrapped onto [start, head) meanwhile.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (head_.load(std::memory_order_relaxed) - start <= buf_.size()) {
+            *writtenAt = head;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,31 @@
+// audio_ring.h
+// Single-producer/single-consumer sample ring between the audio callback and feature extraction
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The producer (PortAudio callback) appends mono samples; the consumer copies out the newest
+// window without ever blocking it. No locks, no allocations after construction.
+class AudioRing {
+public:
+    // `capacity` is rounded up to a power of two.
+    explicit AudioRing(size_t capacity);
+
+    // Producer: downmix `frames` interleaved float32 frames of `channels` and append them.
+    void write(const float *interleaved, size_t frames, int channels);
+
+    // Consumer: copy the newest `n` samples (oldest first) into `out` and report the total
+    // written at that point. Returns false until `n` samples exist; a copy the producer laps
+    // is retried.
+    bool readLatest(float *out, size_t n, uint64_t *writtenAt) const;
+
+    uint64_t written() const { return head_.load(std::memory_order_acquire); }
+    size_t capacity() const { return buf_.size(); }
+
+private:
+    std::vector<float> buf_;
+    size_t mask_;
+    std::atomic<uint64_t> head_; // samples written since construction; only the producer stores
+};
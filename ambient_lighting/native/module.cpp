@@ -0,0 +1,343 @@
+// module.cpp
+// CPython bindings for the native kernels (_ambient_native)
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <new>
+#include "audio_features.h"
+#include "audio_ring.h"
+#include "packet_pacer.h"
+#include "sampler_kernel.h"
+
+// RAII release of a Py_buffer.
+struct BufferView {
+    Py_buffer view;
+    bool held = false;
+    ~BufferView() {
+        if (held) PyBuffer_Release(&view);
+    }
+};
+
+// sample_columns(src, width, height, stride, cells_x, cells_y, row_top, row_bottom, out[, src_row0])
+// src: any buffer of BGRA pixels (mss ScreenShot.raw, bytes, a numpy array) holding the rows of
+// a width x height frame from src_row0 on; only the rows under [row_top, row_bottom) are read.
+// out: writable buffer of at least cells_x * 8 float64 (a preallocated numpy array), filled
+// per sampler_kernel.h. The GIL is released while the kernel runs.
+static PyObject *sampleColumns(PyObject * /*self*/, PyObject *args) {
+    PyObject *srcObj;
+    PyObject *outObj;
+    int width, height, cellsX, cellsY, rowTop, rowBottom;
+    int row0 = 0;
+    Py_ssize_t stride;
+    if (!PyArg_ParseTuple(args, "OiiniiiiO|i", &srcObj, &width, &height, &stride, &cellsX, &cellsY, &rowTop,
+                          &rowBottom, &outObj, &row0)) {
+        return nullptr;
+    }
+    if (width <= 0 || height <= 0 || stride < Py_ssize_t(width) * 4) {
+        PyErr_SetString(PyExc_ValueError, "bad frame geometry");
+        return nullptr;
+    }
+    if (cellsX <= 0 || cellsX > SAMPLER_MAX_CELLS_X || cellsY <= 0 || cellsX > width || cellsY > height) {
+        PyErr_SetString(PyExc_ValueError, "bad downscale size");
+        return nullptr;
+    }
+
+    int first, last;
+    samplerRowSpan(height, cellsY, rowTop, rowBottom, &first, &last);
+    if (row0 < 0 || (last > first && row0 > first)) {
+        PyErr_SetString(PyExc_ValueError, "src starts after the first sampled row");
+        return nullptr;
+    }
+
+    BufferView src, out;
+    if (PyObject_GetBuffer(srcObj, &src.view, PyBUF_C_CONTIGUOUS) < 0) return nullptr;
+    src.held = true;
+    if (last > first && src.view.len < stride * (last - row0 - 1) + Py_ssize_t(width) * 4) {
+        PyErr_SetString(PyExc_ValueError, "source buffer smaller than the frame");
+        return nullptr;
+    }
+    if (PyObject_GetBuffer(outObj, &out.view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE | PyBUF_FORMAT) < 0) {
+        return nullptr;
+    }
+    out.held = true;
+    const char *fmt = out.view.format ? out.view.format : "B";
+    if (out.view.itemsize != sizeof(double) || (fmt[0] != 'd' && !(fmt[0] == '<' && fmt[1] == 'd')) ||
+        out.view.len < Py_ssize_t(sizeof(double)) * cellsX * SAMPLER_FIELDS) {
+        PyErr_SetString(PyExc_ValueError, "out must be a float64 buffer of cells_x * 8 items");
+        return nullptr;
+    }
+
+    SamplerFrame frame;
+    frame.pixels = static_cast<const uint8_t *>(src.view.buf);
+    frame.width = width;
+    frame.height = height;
+    frame.stride = size_t(stride);
+    frame.firstRow = row0;
+    double *acc = static_cast<double *>(out.view.buf);
+    Py_BEGIN_ALLOW_THREADS
+    samplerAccumulate(frame, cellsX, cellsY, rowTop, rowBottom, acc);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// AudioTap(window, sample_rate, hann=False): AudioRing + AudioAnalyzer. write() is the
+// producer (audio callback), analyze() the single consumer; neither holds the GIL while it
+// touches the ring, so the callback never waits on feature extraction.
+struct AudioTapObject {
+    PyObject_HEAD
+    AudioRing *ring;
+    AudioAnalyzer *analyzer;
+    float *window; // consumer scratch, analyzer->size() samples
+    uint64_t lastWritten;
+};
+
+static int audioTapInit(AudioTapObject *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"window", "sample_rate", "hann", nullptr};
+    int n;
+    double sampleRate;
+    int hann = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "id|p", const_cast<char **>(kwlist), &n, &sampleRate, &hann)) {
+        return -1;
+    }
+    if (n < 64 || n > (1 << 20) || (n & (n - 1)) != 0 || sampleRate <= 0.0) {
+        PyErr_SetString(PyExc_ValueError, "window must be a power of two >= 64 and sample_rate > 0");
+        return -1;
+    }
+    delete self->ring;
+    delete self->analyzer;
+    delete[] self->window;
+    self->ring = nullptr;
+    self->analyzer = nullptr;
+    self->window = nullptr;
+    // Four windows of history so a consumer copy is almost never lapped.
+    self->ring = new (std::nothrow) AudioRing(size_t(n) * 4);
+    self->analyzer = new (std::nothrow) AudioAnalyzer(n, sampleRate, hann != 0);
+    self->window = new (std::nothrow) float[n];
+    self->lastWritten = 0;
+    if (!self->ring || !self->analyzer || !self->window) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+static void audioTapDealloc(AudioTapObject *self) {
+    delete self->ring;
+    delete self->analyzer;
+    delete[] self->window;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+// write(block): float32 samples, shape (frames,) or (frames, channels), C-contiguous.
+static PyObject *audioTapWrite(AudioTapObject *self, PyObject *arg) {
+    if (!self->ring) {
+        PyErr_SetString(PyExc_RuntimeError, "AudioTap not initialized");
+        return nullptr;
+    }
+    BufferView block;
+    if (PyObject_GetBuffer(arg, &block.view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) return nullptr;
+    block.held = true;
+    const char *fmt = block.view.format ? block.view.format : "B";
+    if (block.view.itemsize != sizeof(float) || (fmt[0] != 'f' && !(fmt[0] == '<' && fmt[1] == 'f')) ||
+        block.view.ndim < 1 || block.view.ndim > 2) {
+        PyErr_SetString(PyExc_ValueError, "block must be float32 with shape (frames,) or (frames, channels)");
+        return nullptr;
+    }
+    const size_t frames = size_t(block.view.shape[0]);
+    const int channels = block.view.ndim == 2 ? int(block.view.shape[1]) : 1;
+    if (channels <= 0) Py_RETURN_NONE;
+    const float *samples = static_cast<const float *>(block.view.buf);
+    AudioRing *ring = self->ring;
+    Py_BEGIN_ALLOW_THREADS
+    ring->write(samples, frames, channels);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// analyze() -> (low, mid, centroid, new_samples) over the newest `window` samples, where
+// new_samples counts samples written since the previous analyze(); None until a full window.
+static PyObject *audioTapAnalyze(AudioTapObject *self, PyObject * /*args*/) {
+    if (!self->ring) {
+        PyErr_SetString(PyExc_RuntimeError, "AudioTap not initialized");
+        return nullptr;
+    }
+    bool ok;
+    uint64_t writtenAt = 0;
+    AudioFeatures f = {0.0, 0.0, 0.0};
+    Py_BEGIN_ALLOW_THREADS
+    ok = self->ring->readLatest(self->window, size_t(self->analyzer->size()), &writtenAt);
+    if (ok) f = self->analyzer->analyze(self->window);
+    Py_END_ALLOW_THREADS
+    if (!ok) Py_RETURN_NONE;
+    const unsigned long long fresh = writtenAt - self->lastWritten;
+    self->lastWritten = writtenAt;
+    return Py_BuildValue("dddK", f.low, f.mid, f.centroid, fresh);
+}
+
+static PyObject *audioTapWritten(AudioTapObject *self, void * /*closure*/) {
+    return PyLong_FromUnsignedLongLong(self->ring ? self->ring->written() : 0);
+}
+
+static PyMethodDef kAudioTapMethods[] = {
+    {"write", reinterpret_cast<PyCFunction>(audioTapWrite), METH_O, "Append a float32 block (producer side)."},
+    {"analyze", reinterpret_cast<PyCFunction>(audioTapAnalyze), METH_NOARGS,
+     "FFT features of the newest window (single consumer)."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyGetSetDef kAudioTapGetSet[] = {
+    {const_cast<char *>("written"), reinterpret_cast<getter>(audioTapWritten), nullptr,
+     const_cast<char *>("Samples written since creation."), nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+static PyTypeObject kAudioTapType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+// PacketPacer(host, port, rate_hz, multicast_ttl=1): starts sending at rate_hz on a native
+// thread. submit() hands over the packet for the next deadline; next_slot() tells the
+// producer which deadline that is so it can stamp and build just ahead of it.
+struct PacketPacerObject {
+    PyObject_HEAD
+    PacketPacer *pacer;
+};
+
+static int packetPacerInit(PacketPacerObject *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"host", "port", "rate_hz", "multicast_ttl", nullptr};
+    const char *host;
+    int port;
+    double rateHz;
+    int ttl = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "sid|i", const_cast<char **>(kwlist), &host, &port, &rateHz, &ttl)) {
+        return -1;
+    }
+    delete self->pacer;
+    self->pacer = new (std::nothrow) PacketPacer();
+    if (!self->pacer) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    std::string error;
+    if (!self->pacer->start(host, port, rateHz, ttl, &error)) {
+        delete self->pacer;
+        self->pacer = nullptr;
+        PyErr_SetString(PyExc_ValueError, error.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+static void packetPacerStop(PacketPacerObject *self) {
+    PacketPacer *pacer = self->pacer;
+    self->pacer = nullptr;
+    if (!pacer) return;
+    Py_BEGIN_ALLOW_THREADS
+    delete pacer; // joins the send thread (at most one period)
+    Py_END_ALLOW_THREADS
+}
+
+static void packetPacerDealloc(PacketPacerObject *self) {
+    packetPacerStop(self);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+static PacketPacer *runningPacer(PacketPacerObject *self) {
+    if (!self->pacer) PyErr_SetString(PyExc_RuntimeError, "PacketPacer is closed");
+    return self->pacer;
+}
+
+static PyObject *packetPacerSubmit(PacketPacerObject *self, PyObject *arg) {
+    PacketPacer *pacer = runningPacer(self);
+    if (!pacer) return nullptr;
+    BufferView packet;
+    if (PyObject_GetBuffer(arg, &packet.view, PyBUF_C_CONTIGUOUS) < 0) return nullptr;
+    packet.held = true;
+    if (!pacer->submit(static_cast<const uint8_t *>(packet.view.buf), size_t(packet.view.len))) {
+        PyErr_SetString(PyExc_ValueError, "packet must be 1..1472 bytes");
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+// next_slot() -> (deadline_ms, seconds_until): the deadline the next submit() is sent at.
+static PyObject *packetPacerNextSlot(PacketPacerObject *self, PyObject * /*args*/) {
+    PacketPacer *pacer = runningPacer(self);
+    if (!pacer) return nullptr;
+    return Py_BuildValue("Ld", static_cast<long long>(pacer->nextDeadlineMs()), pacer->microsUntilNext() / 1e6);
+}
+
+static PyObject *packetPacerStats(PacketPacerObject *self, PyObject * /*args*/) {
+    PacketPacer *pacer = runningPacer(self);
+    if (!pacer) return nullptr;
+    const PacerStats st = pacer->stats();
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:d}", "sent", static_cast<unsigned long long>(st.sent), "idle",
+                         static_cast<unsigned long long>(st.idle), "replaced",
+                         static_cast<unsigned long long>(st.replaced), "resyncs",
+                         static_cast<unsigned long long>(st.resyncs), "max_late_ms", st.maxLateUs / 1000.0);
+}
+
+static PyObject *packetPacerClose(PacketPacerObject *self, PyObject * /*args*/) {
+    packetPacerStop(self);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef kPacketPacerMethods[] = {
+    {"submit", reinterpret_cast<PyCFunction>(packetPacerSubmit), METH_O, "Packet for the next deadline."},
+    {"next_slot", reinterpret_cast<PyCFunction>(packetPacerNextSlot), METH_NOARGS,
+     "(deadline_ms, seconds_until) of the next send."},
+    {"stats", reinterpret_cast<PyCFunction>(packetPacerStats), METH_NOARGS, "Send counters and worst lateness."},
+    {"close", reinterpret_cast<PyCFunction>(packetPacerClose), METH_NOARGS, "Stop the send thread."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyTypeObject kPacketPacerType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+static PyObject *simd(PyObject * /*self*/, PyObject * /*args*/) {
+    return PyUnicode_FromString(samplerSimdName());
+}
+
+static PyMethodDef kMethods[] = {
+    {"sample_columns", sampleColumns, METH_VARARGS, "Fused BGRA downscale/crop/S-V weighting into per-column sums."},
+    {"simd", simd, METH_NOARGS, "Instruction set the kernels use on this CPU."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyModuleDef kModule = {
+    PyModuleDef_HEAD_INIT, "_ambient_native", "Native kernels for the ambient lighting laptop app.", -1, kMethods,
+    nullptr, nullptr, nullptr, nullptr,
+};
+
+PyMODINIT_FUNC PyInit__ambient_native(void) {
+    kAudioTapType.tp_name = "_ambient_native.AudioTap";
+    kAudioTapType.tp_basicsize = sizeof(AudioTapObject);
+    kAudioTapType.tp_flags = Py_TPFLAGS_DEFAULT;
+    kAudioTapType.tp_doc = "Lock-free audio ring with FFT feature extraction.";
+    kAudioTapType.tp_new = PyType_GenericNew;
+    kAudioTapType.tp_init = reinterpret_cast<initproc>(audioTapInit);
+    kAudioTapType.tp_dealloc = reinterpret_cast<destructor>(audioTapDealloc);
+    kAudioTapType.tp_methods = kAudioTapMethods;
+    kAudioTapType.tp_getset = kAudioTapGetSet;
+    if (PyType_Ready(&kAudioTapType) < 0) return nullptr;
+
+    kPacketPacerType.tp_name = "_ambient_native.PacketPacer";
+    kPacketPacerType.tp_basicsize = sizeof(PacketPacerObject);
+    kPacketPacerType.tp_flags = Py_TPFLAGS_DEFAULT;
+    kPacketPacerType.tp_doc = "Fixed-rate UDP sender thread with a latest-packet mailbox.";
+    kPacketPacerType.tp_new = PyType_GenericNew;
+    kPacketPacerType.tp_init = reinterpret_cast<initproc>(packetPacerInit);
+    kPacketPacerType.tp_dealloc = reinterpret_cast<destructor>(packetPacerDealloc);
+    kPacketPacerType.tp_methods = kPacketPacerMethods;
+    if (PyType_Ready(&kPacketPacerType) < 0) return nullptr;
+
+    PyObject *module = PyModule_Create(&kModule);
+    if (!module) return nullptr;
+    PyTypeObject *types[] = {&kAudioTapType, &kPacketPacerType};
+    const char *names[] = {"AudioTap", "PacketPacer"};
+    for (int i = 0; i < 2; ++i) {
+        Py_INCREF(types[i]);
+        if (PyModule_AddObject(module, names[i], reinterpret_cast<PyObject *>(types[i])) < 0) {
+            Py_DECREF(types[i]);
+            Py_DECREF(module);
+            return nullptr;
+        }
+    }
+    return module;
+}
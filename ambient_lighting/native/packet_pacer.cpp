@@ -0,0 +1,171 @@
+// packet_pacer.cpp
+// Fixed-rate UDP emitter: Python hands over built packets, a native thread sends them on
+// absolute deadlines so the cadence does not depend on the GIL or GUI repaint load.
+#include "packet_pacer.h"
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <mmsystem.h>
+typedef SOCKET SocketHandle;
+static const SocketHandle kNoSocket = INVALID_SOCKET;
+static void closeSocket(SocketHandle s) { closesocket(s); }
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+static const SocketHandle kNoSocket = -1;
+static void closeSocket(SocketHandle s) { close(s); }
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static const int kFresh = 4; // middle_ flag: slot holds a packet the consumer has not taken
+// Sleep until this close to a deadline, then yield-spin: OS sleeps overshoot by a tick.
+static const int64_t kSpinUs = 1500;
+
+static int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+PacketPacer::PacketPacer()
+    : back_(0), front_(1), middle_(2), running_(false), nextDeadlineUs_(0), periodUs_(40000),
+      sock_(intptr_t(kNoSocket)), sent_(0), idle_(0), replaced_(0), resyncs_(0), maxLateUs_(0) {
+    std::memset(addr_, 0, sizeof(addr_));
+    for (int i = 0; i < 3; ++i) slots_[i].len = 0;
+}
+
+PacketPacer::~PacketPacer() {
+    stop();
+}
+
+bool PacketPacer::start(const char *host, int port, double rateHz, int multicastTtl, std::string *error) {
+    stop();
+    if (rateHz <= 0.0 || rateHz > 1000.0 || port <= 0 || port > 65535) {
+        *error = "rate must be in (0, 1000] Hz and port in 1..65535";
+        return false;
+    }
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(uint16_t(port));
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        *error = "host must be an IPv4 address";
+        return false;
+    }
+#if defined(_WIN32)
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        *error = "WSAStartup failed";
+        return false;
+    }
+#endif
+    SocketHandle s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == kNoSocket) {
+        *error = "socket() failed";
+        return false;
+    }
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_BROADCAST, reinterpret_cast<const char *>(&on), sizeof(on));
+    if ((ntohl(addr.sin_addr.s_addr) >> 28) == 0xE) { // 224.0.0.0/4
+        const unsigned char ttl = static_cast<unsigned char>(multicastTtl < 1 ? 1 : multicastTtl > 255 ? 255 : multicastTtl);
+        setsockopt(s, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char *>(&ttl), sizeof(ttl));
+    }
+    std::memcpy(addr_, &addr, sizeof(addr));
+    sock_ = intptr_t(s);
+
+    periodUs_ = int64_t(1e6 / rateHz + 0.5);
+    nextDeadlineUs_.store(nowUs() + periodUs_, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&PacketPacer::run, this);
+    return true;
+}
+
+void PacketPacer::stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) thread_.join();
+    if (SocketHandle(sock_) != kNoSocket) {
+        closeSocket(SocketHandle(sock_));
+        sock_ = intptr_t(kNoSocket);
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+    }
+}
+
+bool PacketPacer::submit(const uint8_t *data, size_t len) {
+    if (len == 0 || len > PACER_MAX_PACKET) return false;
+    Slot &slot = slots_[back_];
+    std::memcpy(slot.data, data, len);
+    slot.len = len;
+    // Publish the filled slot; take back whichever slot was in the middle.
+    const int prev = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+    if (prev & kFresh) replaced_.fetch_add(1, std::memory_order_relaxed);
+    back_ = prev & ~kFresh;
+    return true;
+}
+
+bool PacketPacer::takeFresh(const Slot **slot) {
+    if (!(middle_.load(std::memory_order_acquire) & kFresh)) return false;
+    const int prev = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = prev & ~kFresh;
+    *slot = &slots_[front_];
+    return true;
+}
+
+int64_t PacketPacer::microsUntilNext() const {
+    return nextDeadlineUs_.load(std::memory_order_acquire) - nowUs();
+}
+
+void PacketPacer::run() {
+#if defined(_WIN32)
+    timeBeginPeriod(1); // 1 ms scheduler tick while pacing
+#endif
+    const SocketHandle s = SocketHandle(sock_);
+    int64_t deadline = nextDeadlineUs_.load(std::memory_order_acquire);
+    while (running_.load(std::memory_order_acquire)) {
+        int64_t now = nowUs();
+        if (deadline - now > kSpinUs) {
+            std::this_thread::sleep_for(std::chrono::microseconds(deadline - now - kSpinUs));
+            continue; // re-check running_ after every sleep
+        }
+        while ((now = nowUs()) < deadline) std::this_thread::yield();
+
+        const int64_t late = now - deadline;
+        if (late > maxLateUs_.load(std::memory_order_relaxed)) maxLateUs_.store(late, std::memory_order_relaxed);
+        const Slot *slot;
+        if (takeFresh(&slot)) {
+            sendto(s, reinterpret_cast<const char *>(slot->data), int(slot->len), 0,
+                   reinterpret_cast<const sockaddr *>(addr_), sizeof(sockaddr_in));
+            sent_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            idle_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Absolute schedule: lateness on one tick does not shift the following ones.
+        deadline += periodUs_;
+        if (now - deadline > periodUs_) { // suspended or starved; don't burst to catch up
+            deadline = now + periodUs_;
+            resyncs_.fetch_add(1, std::memory_order_relaxed);
+        }
+        nextDeadlineUs_.store(deadline, std::memory_order_release);
+    }
+#if defined(_WIN32)
+    timeEndPeriod(1);
+#endif
+}
+
+PacerStats PacketPacer::stats() const {
+    PacerStats st;
+    st.sent = sent_.load(std::memory_order_relaxed);
+    st.idle = idle_.load(std::memory_order_relaxed);
+    st.replaced = replaced_.load(std::memory_order_relaxed);
+    st.resyncs = resyncs_.load(std::memory_order_relaxed);
+    st.maxLateUs = maxLateUs_.load(std::memory_order_relaxed);
+    return st;
+}
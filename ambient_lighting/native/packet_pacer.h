@@ -0,0 +1,63 @@
+// packet_pacer.h
+// Fixed-rate UDP emitter: Python hands over built packets, a native thread sends them on
+// absolute deadlines so the cadence does not depend on the GIL or GUI repaint load.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Largest datagram accepted by submit() (one Ethernet frame of UDP payload).
+#define PACER_MAX_PACKET 1472
+
+struct PacerStats {
+    uint64_t sent;       // deadlines that sent a fresh packet
+    uint64_t idle;       // deadlines with nothing new to send (producer late)
+    uint64_t replaced;   // packets overwritten before their deadline (producer early twice)
+    uint64_t resyncs;    // schedule restarts after falling more than a period behind
+    int64_t maxLateUs;   // worst observed wake-up lateness after a deadline
+};
+
+class PacketPacer {
+public:
+    PacketPacer();
+    ~PacketPacer();
+
+    // Open the socket and start the send thread. `host` is an IPv4 literal (broadcast and
+    // multicast allowed; multicastTtl applies to multicast targets).
+    bool start(const char *host, int port, double rateHz, int multicastTtl, std::string *error);
+    void stop();
+
+    // Latest-value mailbox (triple buffer): the packet replaces any not yet sent. Single
+    // producer; never blocks. Returns false if len is 0 or above PACER_MAX_PACKET.
+    bool submit(const uint8_t *data, size_t len);
+
+    // Next send deadline in ms on the pacer's monotonic clock, and microseconds until it.
+    int64_t nextDeadlineMs() const { return nextDeadlineUs_.load(std::memory_order_acquire) / 1000; }
+    int64_t microsUntilNext() const;
+
+    PacerStats stats() const;
+
+private:
+    struct Slot {
+        size_t len;
+        uint8_t data[PACER_MAX_PACKET];
+    };
+
+    void run();
+    bool takeFresh(const Slot **slot);
+
+    Slot slots_[3];
+    int back_;                      // producer-owned slot index
+    int front_;                     // consumer-owned slot index
+    std::atomic<int> middle_;       // shared slot index, kFresh bit set when unread
+    std::atomic<bool> running_;
+    std::atomic<int64_t> nextDeadlineUs_;
+    int64_t periodUs_;
+    std::thread thread_;
+    intptr_t sock_;
+    uint8_t addr_[16];              // sockaddr_in
+    std::atomic<uint64_t> sent_, idle_, replaced_, resyncs_;
+    std::atomic<int64_t> maxLateUs_;
+};
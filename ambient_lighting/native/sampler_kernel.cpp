@@ -0,0 +1,218 @@
+// sampler_kernel.cpp
+// Fused downscale + crop + S/V weighting over a BGRA capture (ScreenSampler fast path)
+#include "sampler_kernel.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SAMPLER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SAMPLER_TARGET_AVX2
+#else
+#define SAMPLER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define SAMPLER_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Adds the B, G, R sums of `count` BGRA pixels to sum[0..2].
+typedef void (*SpanSumFn)(const uint8_t *px, int count, uint32_t sum[3]);
+
+static void spanSumScalar(const uint8_t *px, int count, uint32_t sum[3]) {
+    uint32_t b = 0, g = 0, r = 0;
+    for (int i = 0; i < count; ++i, px += 4) {
+        b += px[0];
+        g += px[1];
+        r += px[2];
+    }
+    sum[0] += b;
+    sum[1] += g;
+    sum[2] += r;
+}
+
+#if SAMPLER_X86
+// Mask one channel per 32-bit pixel, then SAD against zero adds 8 bytes per 64-bit lane.
+static void spanSumSse2(const uint8_t *px, int count, uint32_t sum[3]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maskB = _mm_set1_epi32(0x000000FF);
+    const __m128i maskG = _mm_set1_epi32(0x0000FF00);
+    const __m128i maskR = _mm_set1_epi32(0x00FF0000);
+    __m128i accB = zero, accG = zero, accR = zero;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(px + 4 * i));
+        accB = _mm_add_epi64(accB, _mm_sad_epu8(_mm_and_si128(v, maskB), zero));
+        accG = _mm_add_epi64(accG, _mm_sad_epu8(_mm_and_si128(v, maskG), zero));
+        accR = _mm_add_epi64(accR, _mm_sad_epu8(_mm_and_si128(v, maskR), zero));
+    }
+    sum[0] += uint32_t(_mm_cvtsi128_si32(accB) + _mm_cvtsi128_si32(_mm_srli_si128(accB, 8)));
+    sum[1] += uint32_t(_mm_cvtsi128_si32(accG) + _mm_cvtsi128_si32(_mm_srli_si128(accG, 8)));
+    sum[2] += uint32_t(_mm_cvtsi128_si32(accR) + _mm_cvtsi128_si32(_mm_srli_si128(accR, 8)));
+    spanSumScalar(px + 4 * i, count - i, sum);
+}
+
+SAMPLER_TARGET_AVX2 static uint32_t hsum64(__m256i v) {
+    const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return uint32_t(_mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8)));
+}
+
+SAMPLER_TARGET_AVX2 static void spanSumAvx2(const uint8_t *px, int count, uint32_t sum[3]) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maskB = _mm256_set1_epi32(0x000000FF);
+    const __m256i maskG = _mm256_set1_epi32(0x0000FF00);
+    const __m256i maskR = _mm256_set1_epi32(0x00FF0000);
+    __m256i accB = zero, accG = zero, accR = zero;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(px + 4 * i));
+        accB = _mm256_add_epi64(accB, _mm256_sad_epu8(_mm256_and_si256(v, maskB), zero));
+        accG = _mm256_add_epi64(accG, _mm256_sad_epu8(_mm256_and_si256(v, maskG), zero));
+        accR = _mm256_add_epi64(accR, _mm256_sad_epu8(_mm256_and_si256(v, maskR), zero));
+    }
+    sum[0] += hsum64(accB);
+    sum[1] += hsum64(accG);
+    sum[2] += hsum64(accR);
+    // Not the SSE2 version: legacy-SSE code after dirty YMM registers stalls on every span.
+    spanSumScalar(px + 4 * i, count - i, sum);
+}
+
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false; // OS saves YMM state
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#if SAMPLER_NEON
+// vld4 de-interleaves 16 pixels into B, G, R, A lanes; pairwise widening adds accumulate.
+static void spanSumNeon(const uint8_t *px, int count, uint32_t sum[3]) {
+    uint32x4_t accB = vdupq_n_u32(0), accG = vdupq_n_u32(0), accR = vdupq_n_u32(0);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x4_t v = vld4q_u8(px + 4 * i);
+        accB = vpadalq_u16(accB, vpaddlq_u8(v.val[0]));
+        accG = vpadalq_u16(accG, vpaddlq_u8(v.val[1]));
+        accR = vpadalq_u16(accR, vpaddlq_u8(v.val[2]));
+    }
+    uint32_t lanes[4];
+    const uint32x4_t *accs[3] = {&accB, &accG, &accR};
+    for (int c = 0; c < 3; ++c) {
+        vst1q_u32(lanes, *accs[c]);
+        sum[c] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    spanSumScalar(px + 4 * i, count - i, sum);
+}
+#endif
+
+struct Dispatch {
+    SpanSumFn spanSum;
+    const char *name;
+};
+
+static Dispatch pickDispatch() {
+#if SAMPLER_X86
+    if (cpuHasAvx2()) return {spanSumAvx2, "avx2"};
+    return {spanSumSse2, "sse2"};
+#elif SAMPLER_NEON
+    return {spanSumNeon, "neon"};
+#else
+    return {spanSumScalar, "scalar"};
+#endif
+}
+
+static const Dispatch kDispatch = pickDispatch();
+
+// (1 - v / 255) ^ 1.5 per 8-bit V, and OpenCV's S divisor table (hsv_shift = 12).
+struct Tables {
+    double darkWeight[256];
+    uint32_t sdiv[256];
+    Tables() {
+        for (int v = 0; v < 256; ++v) {
+            darkWeight[v] = std::pow(1.0 - v / 255.0, 1.5);
+            sdiv[v] = v ? uint32_t((255 << 12) / double(v) + 0.5) : 0;
+        }
+    }
+};
+
+static const Tables kTables;
+
+// Thresholds of weighted_mean_color() in 8-bit terms: V <= 0.92, S >= 0.08.
+static const int kMaxValue = 234; // 234 / 255 = 0.9176
+static const int kMinSat = 21;    // 21 / 255 = 0.0824
+
+void samplerRowSpan(int height, int cellsY, int rowTop, int rowBottom, int *first, int *last) {
+    if (rowTop < 0) rowTop = 0;
+    if (rowBottom > cellsY) rowBottom = cellsY;
+    if (rowBottom < rowTop) rowBottom = rowTop;
+    *first = int(int64_t(rowTop) * height / cellsY);
+    *last = int(int64_t(rowBottom) * height / cellsY);
+}
+
+void samplerAccumulate(const SamplerFrame &frame, int cellsX, int cellsY, int rowTop, int rowBottom,
+                       double *out) {
+    std::memset(out, 0, sizeof(double) * size_t(cellsX) * SAMPLER_FIELDS);
+    if (cellsX <= 0 || cellsX > SAMPLER_MAX_CELLS_X || cellsY <= 0) return;
+    if (frame.width < cellsX || frame.height < cellsY) return;
+    if (rowTop < 0) rowTop = 0;
+    if (rowBottom > cellsY) rowBottom = cellsY;
+    int first, last;
+    samplerRowSpan(frame.height, cellsY, rowTop, rowBottom, &first, &last);
+    if (first < frame.firstRow) return;
+
+    int x0[SAMPLER_MAX_CELLS_X + 1];
+    for (int cx = 0; cx <= cellsX; ++cx) x0[cx] = int(int64_t(cx) * frame.width / cellsX);
+    uint32_t sums[SAMPLER_MAX_CELLS_X][3];
+
+    for (int cy = rowTop; cy < rowBottom; ++cy) {
+        const int y0 = int(int64_t(cy) * frame.height / cellsY);
+        const int y1 = int(int64_t(cy + 1) * frame.height / cellsY);
+        std::memset(sums, 0, sizeof(sums[0]) * size_t(cellsX));
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t *row = frame.pixels + size_t(y - frame.firstRow) * frame.stride;
+            for (int cx = 0; cx < cellsX; ++cx) {
+                kDispatch.spanSum(row + size_t(x0[cx]) * 4, x0[cx + 1] - x0[cx], sums[cx]);
+            }
+        }
+
+        for (int cx = 0; cx < cellsX; ++cx) {
+            const uint32_t n = uint32_t(y1 - y0) * uint32_t(x0[cx + 1] - x0[cx]);
+            const int b = int((sums[cx][0] + n / 2) / n);
+            const int g = int((sums[cx][1] + n / 2) / n);
+            const int r = int((sums[cx][2] + n / 2) / n);
+            const int v = r > g ? (r > b ? r : b) : (g > b ? g : b);
+            const int lo = r < g ? (r < b ? r : b) : (g < b ? g : b);
+            const int s = int((uint32_t(v - lo) * kTables.sdiv[v] + (1 << 11)) >> 12);
+            if (s < kMinSat) continue;
+            double *acc = out + size_t(cx) * SAMPLER_FIELDS;
+            const double sat = s / 255.0;
+            if (v <= kMaxValue) {
+                const double w = sat * kTables.darkWeight[v];
+                acc[0] += w;
+                acc[1] += w * r;
+                acc[2] += w * g;
+                acc[3] += w * b;
+            }
+            acc[4] += sat;
+            acc[5] += sat * r;
+            acc[6] += sat * g;
+            acc[7] += sat * b;
+        }
+    }
+}
+
+const char *samplerSimdName() {
+    return kDispatch.name;
+}
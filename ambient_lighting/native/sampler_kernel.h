@@ -0,0 +1,37 @@
+// sampler_kernel.h
+// Fused downscale + crop + S/V weighting over a BGRA capture (ScreenSampler fast path)
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Largest supported downscale width; the per-cell sums live on the stack.
+#define SAMPLER_MAX_CELLS_X 256
+
+// Doubles written per downscaled column, in this order:
+//   0 weight sum       W  = sum of S * (1 - V)^1.5 over cells with V <= 0.92 and S >= 0.08
+//   1-3 W-weighted R, G, B sums
+//   4 fallback weight  W2 = sum of S over cells with S >= 0.08 (bright saturated scenes)
+//   5-7 W2-weighted R, G, B sums
+// S and V are computed like OpenCV's 8-bit RGB2HSV on the rounded cell mean, so this
+// matches ScreenSampler.process_image() + weighted_mean_color() on the same frame.
+#define SAMPLER_FIELDS 8
+
+struct SamplerFrame {
+    const uint8_t *pixels; // BGRA, 4 bytes per pixel, starting at source row firstRow
+    int width, height;     // full frame size the cells are laid over
+    size_t stride;         // bytes per row
+    int firstRow;          // rows above it were not captured (a grab of the uncropped band)
+};
+
+// Source rows [*first, *last) that samplerAccumulate() reads for these cell rows.
+void samplerRowSpan(int height, int cellsY, int rowTop, int rowBottom, int *first, int *last);
+
+// Box-average `frame` down to cellsX x cellsY (each cell covers whole source pixels, the
+// same as INTER_AREA when the sizes divide evenly), skipping source rows of cell rows
+// outside [rowTop, rowBottom); only those rows need to be present in `frame`. Writes cellsX * SAMPLER_FIELDS doubles to `out`. No
+// allocations; safe to run without the GIL.
+void samplerAccumulate(const SamplerFrame &frame, int cellsX, int cellsY, int rowTop, int rowBottom,
+                       double *out);
+
+// Instruction set picked at runtime: "avx2", "sse2", "neon" or "scalar".
+const char *samplerSimdName();
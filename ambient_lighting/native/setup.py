@@ -0,0 +1,37 @@
+"""
+setup.py
+Builds the optional _ambient_native extension next to this file:
+
+    cd ambient_lighting/native
+    python setup.py build_ext --inplace
+
+Without it the laptop app uses its numpy/OpenCV code paths unchanged.
+"""
+import sys
+
+from setuptools import Extension, setup
+
+if sys.platform == 'win32':
+    compile_args = ['/O2', '/std:c++14']
+    link_args = []
+    libraries = ['ws2_32', 'winmm']  # PacketPacer socket + 1 ms timer resolution
+else:
+    # AVX2 code is compiled per function (target attribute) and picked at runtime.
+    compile_args = ['-O3', '-std=c++11', '-fno-strict-aliasing', '-pthread']
+    link_args = ['-pthread']
+    libraries = []
+
+setup(
+    name='ambient-native',
+    version='1.0',
+    ext_modules=[
+        Extension(
+            '_ambient_native',
+            sources=['module.cpp', 'sampler_kernel.cpp', 'audio_ring.cpp', 'audio_features.cpp', 'packet_pacer.cpp'],
+            language='c++',
+            extra_compile_args=compile_args,
+            extra_link_args=link_args,
+            libraries=libraries,
+        )
+    ],
+)
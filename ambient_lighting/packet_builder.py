@@ -2,26 +2,122 @@
 packet_builder.py
 Builds UDP packets for ESP32 ambient lighting according to protocol in PROJECT_SPEC.md.
 """
+import struct
+import time
+
 import numpy as np
 
+V2_MAGIC = 0xA5
+V2_VERSION = 2
+# v2 extension flags (byte 2); present extensions follow the timestamp in bit order.
+V2_FLAG_ZONES = 0x01
+V2_FLAG_SYNC = 0x02
+V2_FLAG_BEAT = 0x04
+V2_MAX_ZONES = 32
+# A beat is repeated in every packet until it is this old, so one lost packet does not drop it.
+V2_BEAT_MAX_AGE_MS = 255
+
+# DDP raw pixel stream (firmware RAW_STREAM_PORT): 10-byte header + RGB payload.
+DDP_FLAGS_VER1 = 0x40
+DDP_FLAG_PUSH = 0x01
+DDP_TYPE_RGB8 = 0x0B
+DDP_DEST_DISPLAY = 0x01
+DDP_MAX_PIXELS_PER_PACKET = 480  # 1440-byte payload keeps each datagram under a 1500-byte MTU
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), as checked by the ESP32 (protocol.cpp)."""
+    for byte in data:
+        crc ^= int(byte) << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else:
+                crc = (crc << 1) & 0xFFFF
+    return crc
+
+
 class PacketBuilder:
     def __init__(self, config):
         self.config = config
 
+    def _fields(self, data):
+        # Shared payload: mode, R, G, B, brightness, motion energy, motion speed, direction
+        fields = np.zeros(8, dtype=np.uint8)
+        fields[0] = data.get('mode', 1)
+        rgb = np.clip(np.round(data.get('base_color', [0,0,0])), 0, 255).astype(np.uint8)
+        fields[1:4] = rgb
+        fields[4] = np.clip(int(data.get('brightness', 70)), 0, self.config.led_brightness_cap)
+        fields[5] = np.clip(int(data.get('motion_energy', 0)), 0, 180)
+        fields[6] = np.clip(int(data.get('motion_speed', 0.15) * 100), 0, 255)
+        fields[7] = int(data.get('direction', 0))
+        return fields
+
     def build(self, data):
+        if int(getattr(self.config, 'udp_protocol_version', 1)) >= 2:
+            return self.build_v2(data)
         # Build 12-byte packet
         packet = np.zeros(12, dtype=np.uint8)
         packet[0] = 0xAA  # Header
-        packet[1] = data.get('mode', 1)
-        rgb = np.clip(np.round(data.get('base_color', [0,0,0])), 0, 255).astype(np.uint8)
-        packet[2:5] = rgb
-        packet[5] = np.clip(int(data.get('brightness', 70)), 0, self.config.led_brightness_cap)
-        packet[6] = np.clip(int(data.get('motion_energy', 0)), 0, 180)
-        packet[7] = np.clip(int(data.get('motion_speed', 0.15) * 100), 0, 255)
-        packet[8] = int(data.get('direction', 0))
+        packet[1:9] = self._fields(data)
         # Byte 9: frame_id (0-255 wrap). Used for loss/reorder detection on ESP32.
         packet[9] = int(data.get('frame_id', 0)) & 0xFF
         # Checksum: XOR bytes 1-9
         packet[10] = np.bitwise_xor.reduce(packet[1:10])
         packet[11] = 0x55  # Footer
         return packet.tobytes()
+
+    def build_v2(self, data):
+        # Build v2 packet: magic, version, flags, fields, seq16, sender_ms32, [extensions], crc16 (LE)
+        seq = int(data.get('seq', data.get('frame_id', 0))) & 0xFFFF
+        sender_ms = int(data.get('sender_ms', time.monotonic() * 1000.0)) & 0xFFFFFFFF
+        flags = 0
+        ext = b''
+        # Zone extension: [count][count x R,G,B], zones ordered from LED 0 to the strip end.
+        zones = data.get('zones')
+        if zones is not None and len(zones) > 0:
+            z = np.clip(np.round(np.asarray(zones, dtype=np.float32)), 0, 255).astype(np.uint8).reshape(-1, 3)
+            z = z[:V2_MAX_ZONES]
+            flags |= V2_FLAG_ZONES
+            ext += bytes([len(z)]) + z.tobytes()
+        # Sync extension: [present delay ms]; all units play the packet out at the same instant.
+        sync_ms = int(getattr(self.config, 'sync_present_delay_ms', 0))
+        if sync_ms > 0:
+            flags |= V2_FLAG_SYNC
+            ext += bytes([min(sync_ms, 255)])
+        # Beat extension: [beat id][strength 0-255][age ms before sender_ms]; the firmware starts
+        # the envelope once per new id, at its playout time minus the age.
+        beat = data.get('beat')
+        if beat is not None:
+            beat_id, strength, beat_ms = beat
+            age = (sender_ms - int(beat_ms)) & 0xFFFFFFFF
+            if age >= 0x80000000:
+                age = 0  # stamped after the packet's send time (pacer deadline ahead of now)
+            if age <= V2_BEAT_MAX_AGE_MS:
+                flags |= V2_FLAG_BEAT
+                ext += bytes([int(beat_id) & 0xFF, int(min(max(strength, 0.0), 1.0) * 255 + 0.5), age])
+        body = bytes([V2_MAGIC, V2_VERSION, flags]) + self._fields(data).tobytes() + struct.pack('<HI', seq, sender_ms) + ext
+        return body + struct.pack('<H', crc16_ccitt(body))
+
+    def build_raw_frame(self, pixels, seq=0):
+        """
+        Split a full LED frame into DDP datagrams.
+        Args:
+            pixels: (N, 3) RGB array, LED 0 first.
+            seq: frame sequence; DDP uses the low 4 bits (1-15, 0 = unused).
+        Returns:
+            list[bytes]: datagrams in offset order; the last one carries the PUSH flag.
+        """
+        rgb = np.clip(np.round(np.asarray(pixels, dtype=np.float32)), 0, 255).astype(np.uint8).reshape(-1, 3)
+        payload = rgb.tobytes()
+        seq4 = (int(seq) % 15) + 1
+        chunk = DDP_MAX_PIXELS_PER_PACKET * 3
+        packets = []
+        for offset in range(0, max(len(payload), 1), chunk):
+            part = payload[offset:offset + chunk]
+            flags = DDP_FLAGS_VER1
+            if offset + chunk >= len(payload):
+                flags |= DDP_FLAG_PUSH
+            header = struct.pack('>BBBBIH', flags, seq4, DDP_TYPE_RGB8, DDP_DEST_DISPLAY, offset, len(part))
+            packets.append(header + part)
+        return packets
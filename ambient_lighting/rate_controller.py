@@ -0,0 +1,107 @@
+"""
+rate_controller.py
+Adaptive control packet rate: fast while the scene changes, a slow keepalive when it is static.
+
+The UDP thread polls due() at udp_max_rate_hz and builds/sends a packet only when it returns
+True. The interval shrinks with how far the inputs (screen color and zones, motion energies,
+mode) have moved since the last packet:
+  moved < 1 unit          -> 1 / udp_keepalive_hz (never longer than KEEPALIVE_MAX_S)
+  moved >= full delta     -> 1 / udp_max_rate_hz
+  in between              -> linear in rate from udp_rate_hz up to udp_max_rate_hz
+A mode switch, a zone layout change or a new audio beat (modes 2/3) sends at once.
+Each sent packet is built normally, so seq stays contiguous for the firmware.
+"""
+
+# Longest gap between packets. ModeManager and the firmware both fall back after 1.8 s
+# without packets, so keep room for a lost keepalive or two; the firmware's
+# PACKET_MAX_INTERVAL_MS matches this.
+KEEPALIVE_MAX_S = 1.0
+
+
+def _max_abs_diff(a, b):
+    if a is None or b is None:
+        return 0.0 if a is None and b is None else float('inf')
+    a = [float(x) for row in a for x in (row if hasattr(row, '__len__') else (row,))]
+    b = [float(x) for row in b for x in (row if hasattr(row, '__len__') else (row,))]
+    if len(a) != len(b):
+        return float('inf')
+    return max((abs(x - y) for x, y in zip(a, b)), default=0.0)
+
+
+class RateController:
+    def __init__(self, config):
+        self.adaptive = bool(getattr(config, 'udp_adaptive_rate', False))
+        self.base_hz = float(config.udp_rate_hz)
+        self.max_hz = max(float(getattr(config, 'udp_max_rate_hz', self.base_hz)), self.base_hz)
+        keepalive_hz = float(getattr(config, 'udp_keepalive_hz', self.base_hz))
+        self.keepalive_s = min(1.0 / max(keepalive_hz, 1e-3), KEEPALIVE_MAX_S)
+        self.full_delta = max(float(getattr(config, 'udp_rate_full_delta', 8.0)), 1.0)
+        # Beat ids only reach the firmware in v2 packets; under v1 a new beat changes nothing sent.
+        self.beats = int(getattr(config, 'udp_protocol_version', 1)) >= 2
+        self._last_sent_at = None
+        self._snapshot = None
+
+    @property
+    def poll_interval_s(self):
+        """How often the UDP thread should call due()."""
+        return 1.0 / (self.max_hz if self.adaptive else self.base_hz)
+
+    @property
+    def send_rate_hz(self):
+        """Slot rate for the native pacer: every packet lands on one of its deadlines."""
+        return self.max_hz if self.adaptive else self.base_hz
+
+    def _inputs(self, data):
+        return (
+            data.get('mode'),
+            data.get('base_color'),
+            data.get('zone_colors'),
+            float(data.get('screen_motion_energy', 0.0)),
+            float(data.get('audio_motion_energy', 0.0)),
+            data.get('audio_beat_id') if self.beats and data.get('mode') in (2, 3) else None,
+        )
+
+    def change(self, data):
+        """How far the inputs moved since the last sent packet (color / energy units)."""
+        if self._snapshot is None:
+            return float('inf')
+        mode, color, zones, screen_motion, audio_motion, beat = self._inputs(data)
+        last_mode, last_color, last_zones, last_screen, last_audio, last_beat = self._snapshot
+        if mode != last_mode or beat != last_beat:
+            return float('inf')
+        return max(
+            _max_abs_diff(color, last_color),
+            _max_abs_diff(zones, last_zones),
+            abs(screen_motion - last_screen),
+            abs(audio_motion - last_audio),
+        )
+
+    def interval_s(self, change):
+        """Packet interval for an input change of `change` units."""
+        if not self.adaptive:
+            return 1.0 / self.base_hz
+        if change < 1.0:
+            return self.keepalive_s
+        level = min(change / self.full_delta, 1.0)
+        return 1.0 / (self.base_hz + (self.max_hz - self.base_hz) * level)
+
+    def due(self, data, now):
+        """True if a packet should be built and sent now (call with data_lock held)."""
+        if self._last_sent_at is None:
+            return True
+        change = self.change(data)
+        if change == float('inf'):
+            return True  # mode switch, zone layout change or new beat
+        # Half a poll of slack so a sleep that wakes a little early still sends.
+        elapsed = now - self._last_sent_at + 0.5 * self.poll_interval_s
+        return elapsed >= self.interval_s(change)
+
+    def start_packet(self, data, now):
+        """Record the inputs of the packet about to be built (before ModeManager rewrites them)."""
+        mode, color, zones, screen_motion, audio_motion, beat = self._inputs(data)
+        if color is not None:
+            color = [float(x) for x in color]
+        if zones is not None:
+            zones = [[float(x) for x in z] for z in zones]
+        self._snapshot = (mode, color, zones, screen_motion, audio_motion, beat)
+        self._last_sent_at = now
@@ -0,0 +1,74 @@
+"""
+scene_client.py
+Builds and uploads the ESP32 scene engine's records (control command 0x04): the procedural
+effects a unit shows on its own while no laptop is sending.
+Layout must match firmware/main/protocol.h and scenes.h.
+"""
+import socket
+import struct
+
+from packet_builder import crc16_ccitt
+
+CONTROL_MAGIC = 0xA6
+CONTROL_REPLY = 0x80
+CONTROL_CMD_SCENES = 0x04
+CONTROL_SCENES_PERSIST = 0x01
+
+SCENE_OK, SCENE_BAD, SCENE_BUSY = 0, 1, 2
+SCENE_RECORD_BYTES = 12
+SCENE_SLOTS = 4
+
+EFFECTS = {'breathe': 0, 'noise': 1, 'gradient': 2, 'sunrise': 3}
+SCENE_FLAG_LAST_COLOR = 0x01
+
+
+def build_scene_record(effect, color1=(255, 180, 80), color2=(255, 90, 20), brightness=110,
+                       speed=21, scale=16, minutes=30, last_color=False):
+    """One 12-byte record. `speed` is the time step in 1/16 per ms, `scale` the spatial step,
+    `minutes` the sunrise length; `last_color` takes color1 and brightness from the last scene
+    the laptop sent instead."""
+    if isinstance(effect, str):
+        effect = EFFECTS[effect]
+    values = [effect, SCENE_FLAG_LAST_COLOR if last_color else 0, brightness, speed, scale, minutes]
+    values += list(color1) + list(color2)
+    if len(values) != SCENE_RECORD_BYTES or not 0 <= effect < len(EFFECTS) or any(not 0 <= v <= 255 for v in values):
+        raise ValueError('invalid scene record %r' % (values,))
+    return bytes(values)
+
+
+def build_scene_request(records, active=0, persist=False):
+    """Replace the unit's scenes with `records` and show `active`; an empty list only selects
+    `active` among the installed ones."""
+    if len(records) > SCENE_SLOTS or any(len(r) != SCENE_RECORD_BYTES for r in records):
+        raise ValueError('at most %d records of %d bytes' % (SCENE_SLOTS, SCENE_RECORD_BYTES))
+    flags = CONTROL_SCENES_PERSIST if persist else 0
+    body = bytes([CONTROL_MAGIC, CONTROL_CMD_SCENES, flags, active, len(records)]) + b''.join(records)
+    return body + struct.pack('<H', crc16_ccitt(body))
+
+
+def parse_scene_reply(data):
+    """Return the status byte of a scene reply, or None if it is not one."""
+    if len(data) != 3 or data[0] != CONTROL_MAGIC or data[1] != (CONTROL_CMD_SCENES | CONTROL_REPLY):
+        return None
+    return data[2]
+
+
+def upload_scenes(ip, port, records, active=0, persist=False, timeout=0.5, retries=3):
+    """Send one scene request, retrying while the device reports busy. Returns the status or None."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        sock.settimeout(timeout)
+        request = build_scene_request(records, active, persist)
+        status = None
+        for _ in range(retries):
+            sock.sendto(request, (ip, port))
+            try:
+                data, _ = sock.recvfrom(64)
+            except socket.timeout:
+                continue
+            status = parse_scene_reply(data)
+            if status != SCENE_BUSY:
+                break
+        return status
+    finally:
+        sock.close()
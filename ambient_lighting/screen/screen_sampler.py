@@ -10,8 +10,13 @@ import mss
 import cv2
 import time
 
+try:
+    from native import SAMPLE_FIELDS, ext as native_ext
+except ImportError:  # run as a script from screen/
+    SAMPLE_FIELDS, native_ext = 8, None
+
 class ScreenSampler:
-    def __init__(self, downscale_size=(64, 36), crop_top=0.07, crop_bottom=0.13, ema_ms=600, desat_amount=0.12, dark_boost=False, dark_boost_v_thresh=0.25, dark_boost_strength=0.15):
+    def __init__(self, downscale_size=(64, 36), crop_top=0.07, crop_bottom=0.13, ema_ms=600, desat_amount=0.12, dark_boost=False, dark_boost_v_thresh=0.25, dark_boost_strength=0.15, use_native=False):
         """
         Initialize the screen sampler.
         Args:
@@ -19,6 +24,8 @@ class ScreenSampler:
             crop_top: Fraction to crop from the top of the image.
             crop_bottom: Fraction to crop from the bottom of the image.
             ema_ms: EMA smoothing window in milliseconds (800ms).
+            use_native: Sample raw BGRA captures with the native kernel (native/) when it is
+                built; otherwise (or when False) use the OpenCV/numpy path.
         """
         self.downscale_size = downscale_size
         self.crop_top = crop_top
@@ -29,7 +36,12 @@ class ScreenSampler:
         self.dark_boost_v_thresh = dark_boost_v_thresh
         self.dark_boost_strength = dark_boost_strength
         self.last_color = np.array([0, 0, 0], dtype=np.float32)
+        self.last_zone_colors = None
         self.last_capture_success = True
+        self.native = native_ext if use_native else None
+        self._columns = None  # reused sample_columns() output
+        self._sct = None  # mss session, kept open between grabs
+        self._sct_opened = 0.0
 
     def _compute_ema_alpha(self, ema_ms):
         # Calculate EMA alpha for smoothing
@@ -38,6 +50,32 @@ class ScreenSampler:
         n = ema_ms / frame_ms
         return 1 - np.exp(-1 / n)
 
+    # Reopen the mss session this often so monitor geometry changes are picked up.
+    SESSION_MAX_AGE_S = 10.0
+
+    def _session(self):
+        """
+        The mss session, opened on first use and then reused: opening one per grab costs a
+        display connection (X11) or device contexts (Windows) every frame. mss handles are
+        bound to their thread, so a sampler must be used from a single thread.
+        """
+        now = time.monotonic()
+        if self._sct is not None and now - self._sct_opened > self.SESSION_MAX_AGE_S:
+            self.close()
+        if self._sct is None:
+            self._sct = mss.mss()
+            self._sct_opened = now
+        return self._sct
+
+    def close(self):
+        """Release the capture session (the next grab opens a new one)."""
+        if self._sct is not None:
+            try:
+                self._sct.close()
+            except Exception:
+                pass
+            self._sct = None
+
     def capture_screen(self):
         """
         Capture the full screen using mss.
@@ -45,18 +83,97 @@ class ScreenSampler:
             np.ndarray: Captured image in RGB format, or None if failed.
         """
         try:
-            with mss.mss() as sct:
-                monitor = sct.monitors[1]  # Primary monitor
-                img = np.array(sct.grab(monitor))
-                # Convert BGRA to RGB
-                img = img[..., :3][..., ::-1]
-                self.last_capture_success = True
-                return img
+            sct = self._session()
+            shot = sct.grab(sct.monitors[1])  # Primary monitor
+            # View the BGRA buffer in place; cvtColor makes the single RGB copy.
+            bgra = np.frombuffer(shot.raw, dtype=np.uint8).reshape(shot.height, shot.width, 4)
+            img = cv2.cvtColor(bgra, cv2.COLOR_BGRA2RGB)
+            self.last_capture_success = True
+            return img
         except Exception as e:
-            # Handle screen capture failure gracefully
+            # Handle screen capture failure gracefully; reopen the session on the next grab
+            self.close()
+            self.last_capture_success = False
+            return None
+
+    def _crop_rows(self):
+        h = self.downscale_size[1]
+        return int(h * self.crop_top), int(h * (1 - self.crop_bottom))
+
+    def capture_bgra(self):
+        """
+        Capture the primary monitor as mss's raw BGRA buffer, without conversion. Only the
+        band left after crop_top/crop_bottom is read back.
+        Returns:
+            (pixels, width, height, first_row): the band's pixels and the full monitor size,
+            or None if failed.
+        """
+        try:
+            sct = self._session()
+            mon = sct.monitors[1]  # Primary monitor
+            top, bottom = self._crop_rows()
+            y0 = top * mon['height'] // self.downscale_size[1]
+            y1 = bottom * mon['height'] // self.downscale_size[1]
+            if y1 <= y0:
+                y0, y1 = 0, mon['height']
+            band = {'left': mon['left'], 'top': mon['top'] + y0, 'width': mon['width'], 'height': y1 - y0}
+            shot = sct.grab(band)
+            self.last_capture_success = True
+            return shot.raw, mon['width'], mon['height'], y0
+        except Exception:
+            self.close()
             self.last_capture_success = False
             return None
 
+    def sample_columns(self, pixels, width, height, first_row=0, stride=None):
+        """
+        Native equivalent of process_image() + the weighting in weighted_mean_color(): one
+        pass over the BGRA buffer, no temporaries. `pixels` holds the frame's rows from
+        first_row on (see capture_bgra()).
+        Returns:
+            np.ndarray: (downscale width, SAMPLE_FIELDS) float64 per-column sums, reused
+            between calls (layout in native/sampler_kernel.h).
+        """
+        w, h = self.downscale_size
+        if self._columns is None:
+            self._columns = np.zeros((w, SAMPLE_FIELDS), dtype=np.float64)
+        top, bottom = self._crop_rows()
+        self.native.sample_columns(pixels, width, height, stride or width * 4, w, h, top, bottom,
+                                   self._columns, first_row)
+        return self._columns
+
+    def color_from_columns(self, columns):
+        """weighted_mean_color() from sample_columns() sums, including both fallbacks."""
+        total = columns.sum(axis=0)
+        if total[0] > 0:
+            return (total[1:4] / total[0]).astype(np.float32)
+        if total[4] > 0:
+            return (total[5:8] / total[4]).astype(np.float32)
+        return self.last_color.copy()
+
+    def region_colors_from_columns(self, columns, regions=3):
+        """weighted_mean_color_regions() from sample_columns() sums."""
+        w = columns.shape[0]
+        region_colors = []
+        region_weights = []
+        for i in range(regions):
+            x0 = int(i * w / regions)
+            x1 = int((i + 1) * w / regions)
+            reg = columns[x0:x1].sum(axis=0)
+            if reg[0] == 0:
+                region_colors.append(None)
+                region_weights.append(0.0)
+            else:
+                region_colors.append((reg[1:4] / reg[0]).astype(np.float32))
+                region_weights.append(float(reg[0]))
+        return region_colors, region_weights
+
+    def _capture_columns(self):
+        frame = self.capture_bgra()
+        if frame is None:
+            return None
+        return self.sample_columns(*frame)
+
     def process_image(self, img):
         """
         Downscale, crop, and convert image to HSV.
@@ -151,6 +268,30 @@ class ScreenSampler:
                 region_weights.append(float(w_sum))
         return region_colors, region_weights
 
+    def zone_colors(self, hsv, img_cropped, zones, fallback_rgb):
+        """
+        Weighted mean color of `zones` equal-width columns (left to right), EMA-smoothed.
+        Columns without usable pixels take fallback_rgb.
+        Returns:
+            np.ndarray: (zones, 3) float32 RGB colors
+        """
+        region_colors, _ = self.weighted_mean_color_regions(hsv, img_cropped, regions=zones)
+        return self._smooth_zone_colors(region_colors, fallback_rgb)
+
+    def _smooth_zone_colors(self, region_colors, fallback_rgb):
+        zones = len(region_colors)
+        out = np.empty((zones, 3), dtype=np.float32)
+        for i, c in enumerate(region_colors):
+            if c is None:
+                out[i] = fallback_rgb
+            else:
+                out[i] = self.desaturate(self.boost_dark(c), amount=self.desat_amount)
+        if self.last_zone_colors is None or self.last_zone_colors.shape != out.shape:
+            self.last_zone_colors = out
+        else:
+            self.last_zone_colors = self.ema_alpha * out + (1 - self.ema_alpha) * self.last_zone_colors
+        return self.last_zone_colors.copy()
+
     def boost_dark(self, rgb):
         if not self.dark_boost:
             return rgb
@@ -175,12 +316,24 @@ class ScreenSampler:
         self.last_color = self.ema_alpha * rgb + (1 - self.ema_alpha) * self.last_color
         return self.last_color.copy()
 
-    def get_screen_color(self):
+    def get_screen_color(self, zones=0):
         """
         Main entry point: capture, process, compute weighted mean, desaturate, smooth.
+        With zones > 0, also refreshes last_zone_colors from the same capture.
         Returns:
             np.ndarray: Final RGB color (float32, range 0-255)
         """
+        if self.native is not None:
+            columns = self._capture_columns()
+            if columns is None:
+                return self.last_color.copy()
+            rgb = self.color_from_columns(columns)
+            rgb = self.boost_dark(rgb)
+            rgb = self.desaturate(rgb, amount=self.desat_amount)
+            rgb = self.smooth_color(rgb)
+            if zones > 0:
+                self._smooth_zone_colors(self.region_colors_from_columns(columns, zones)[0], rgb)
+            return rgb
         img = self.capture_screen()
         if img is None:
             # Screen capture failed, use last color
@@ -190,16 +343,26 @@ class ScreenSampler:
         rgb = self.boost_dark(rgb)
         rgb = self.desaturate(rgb, amount=self.desat_amount)
         rgb = self.smooth_color(rgb)
+        if zones > 0:
+            self.zone_colors(hsv, img_cropped, zones, rgb)
         return rgb
 
-    def get_screen_data(self, regions=3):
-        """Return (final_color, region_colors, region_weights) for spatial bias logic."""
-        img = self.capture_screen()
-        if img is None:
-            return self.last_color.copy(), [], []
-        hsv, img_cropped = self.process_image(img)
-        rgb = self.weighted_mean_color(hsv, img_cropped)
-        region_colors, region_weights = self.weighted_mean_color_regions(hsv, img_cropped, regions=regions)
+    def get_screen_data(self, regions=3, zones=0):
+        """Return (final_color, region_colors, region_weights) for spatial bias logic.
+        With zones > 0, also refreshes last_zone_colors from the same capture."""
+        if self.native is not None:
+            columns = self._capture_columns()
+            if columns is None:
+                return self.last_color.copy(), [], []
+            rgb = self.color_from_columns(columns)
+            region_colors, region_weights = self.region_colors_from_columns(columns, regions=regions)
+        else:
+            img = self.capture_screen()
+            if img is None:
+                return self.last_color.copy(), [], []
+            hsv, img_cropped = self.process_image(img)
+            rgb = self.weighted_mean_color(hsv, img_cropped)
+            region_colors, region_weights = self.weighted_mean_color_regions(hsv, img_cropped, regions=regions)
 
         def _process(c):
             if c is None:
@@ -212,6 +375,11 @@ class ScreenSampler:
         rgb = self.boost_dark(rgb)
         rgb = self.desaturate(rgb, amount=self.desat_amount)
         rgb = self.smooth_color(rgb)
+        if zones > 0:
+            if self.native is not None:
+                self._smooth_zone_colors(self.region_colors_from_columns(columns, zones)[0], rgb)
+            else:
+                self.zone_colors(hsv, img_cropped, zones, rgb)
         return rgb, region_colors, region_weights
 
 if __name__ == "__main__":
@@ -3,6 +3,8 @@ signal_processing.py
 Signal processing utilities for smoothing motion energy and other signals.
 Strictly follows PROJECT_SPEC.md.
 """
+import math
+
 import numpy as np
 
 class EMA:
@@ -21,3 +23,37 @@ motion_ema = EMA(ms=250, rate_hz=25)
 
 def smooth_motion(x):
     return motion_ema.update(x)
+
+
+class OnsetDetector:
+    """
+    Onsets (beats, hits) from rises in an energy envelope: the positive frame-to-frame step
+    (half-wave rectified flux) must clear `threshold` x its own running mean plus `min_flux`,
+    at most once per `refractory_ms`. update() returns the onset strength (0-1, relative to
+    `full_scale`) or None.
+    """
+    def __init__(self, threshold=1.6, min_flux=8.0, refractory_ms=120.0, mean_ms=400.0, full_scale=160.0):
+        self.threshold = float(threshold)
+        self.min_flux = float(min_flux)
+        self.refractory_ms = float(refractory_ms)
+        self.mean_ms = max(float(mean_ms), 1.0)
+        self.full_scale = max(float(full_scale), 1e-6)
+        self.mean_flux = 0.0
+        self._prev = None
+        self._last_onset_ms = None
+
+    def update(self, x, dt_ms, t_ms):
+        x = float(x)
+        prev, self._prev = self._prev, x
+        if prev is None:
+            return None
+        flux = max(0.0, x - prev)
+        limit = self.threshold * self.mean_flux + self.min_flux
+        alpha = 1.0 - math.exp(-max(float(dt_ms), 0.0) / self.mean_ms)
+        self.mean_flux += alpha * (flux - self.mean_flux)
+        if flux <= limit:
+            return None
+        if self._last_onset_ms is not None and t_ms - self._last_onset_ms < self.refractory_ms:
+            return None
+        self._last_onset_ms = t_ms
+        return min(flux / self.full_scale, 1.0)
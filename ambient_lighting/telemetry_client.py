@@ -0,0 +1,63 @@
+"""
+telemetry_client.py
+Polls the ESP32 telemetry endpoint (control datagram on the UDP port) and decodes the reply.
+Layout must match firmware/main/telemetry.h.
+"""
+import socket
+import struct
+
+from packet_builder import crc16_ccitt
+
+CONTROL_MAGIC = 0xA6
+CONTROL_REPLY = 0x80
+CONTROL_CMD_STATS = 0x01
+CONTROL_STATS_RESET = 0x01
+
+COUNTER_NAMES = (
+    'packets_ok', 'bad_format', 'bad_checksum', 'lost', 'reordered', 'duplicate',
+    'queue_overflow', 'concealed', 'late_dropped', 'frames_rendered', 'frames_skipped',
+    'raw_frames', 'power_limited', 'wifi_reconnects',
+)
+TIMING_NAMES = ('parse', 'state', 'kernel', 'show')
+
+
+def build_stats_request(reset=False):
+    return bytes([CONTROL_MAGIC, CONTROL_CMD_STATS, CONTROL_STATS_RESET if reset else 0])
+
+
+def parse_stats_reply(data):
+    """Decode a stats reply into a dict, or return None if it is not a valid reply."""
+    if len(data) < 11 or data[0] != CONTROL_MAGIC or data[1] != (CONTROL_CMD_STATS | CONTROL_REPLY):
+        return None
+    n_counters, n_timings = data[3], data[4]
+    if len(data) != 9 + n_counters * 4 + n_timings * 20 + 2:
+        return None
+    if struct.unpack_from('<H', data, len(data) - 2)[0] != crc16_ccitt(data[:-2]):
+        return None
+    uptime_ms, = struct.unpack_from('<I', data, 5)
+    values = struct.unpack_from('<%dI' % n_counters, data, 9)
+    # Unknown (newer firmware) entries keep a positional name.
+    counters = {COUNTER_NAMES[i] if i < len(COUNTER_NAMES) else 'counter_%d' % i: v
+                for i, v in enumerate(values)}
+    timings = {}
+    offset = 9 + n_counters * 4
+    for i in range(n_timings):
+        count, lo, avg, hi, p99 = struct.unpack_from('<5I', data, offset)
+        name = TIMING_NAMES[i] if i < len(TIMING_NAMES) else 'timing_%d' % i
+        timings[name] = {'count': count, 'min_us': lo, 'avg_us': avg, 'max_us': hi, 'p99_us': p99}
+        offset += 20
+    return {'version': data[2], 'uptime_ms': uptime_ms, 'counters': counters, 'timings': timings}
+
+
+def poll_stats(ip, port, reset=False, timeout=0.5):
+    """Send one stats request and wait for the reply. Returns the decoded dict or None."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        sock.settimeout(timeout)
+        sock.sendto(build_stats_request(reset), (ip, port))
+        data, _ = sock.recvfrom(1024)
+        return parse_stats_reply(data)
+    except socket.timeout:
+        return None
+    finally:
+        sock.close()
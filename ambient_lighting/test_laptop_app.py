@@ -44,6 +44,43 @@ class TestScreenSampler(unittest.TestCase):
         rgb = self.sampler.weighted_mean_color(hsv, img_cropped)
         self.assertTrue(np.allclose(rgb, np.array([255, 0, 0], dtype=np.float32), atol=1.0))
 
+class TestNativeSampler(unittest.TestCase):
+    def setUp(self):
+        import native
+        if native.ext is None:
+            self.skipTest('native extension not built')
+        self.sampler = ScreenSampler(use_native=True)
+
+    def test_columns_match_numpy_path(self):
+        # Integer downscale ratio, where INTER_AREA is a plain box average like the kernel.
+        rng = np.random.default_rng(7)
+        rgb = rng.integers(0, 256, size=(144, 256, 3), dtype=np.uint8)
+        rgb[:, :64] //= 4  # a dark band so both weighting passes see data
+        bgra = np.dstack([rgb[..., ::-1], np.full(rgb.shape[:2], 255, np.uint8)])
+        columns = self.sampler.sample_columns(bgra.tobytes(), 256, 144)
+        hsv, img_cropped = self.sampler.process_image(rgb)
+        expected = self.sampler.weighted_mean_color(hsv, img_cropped)
+        self.assertTrue(np.allclose(self.sampler.color_from_columns(columns), expected, atol=1.0))
+        regions, weights = self.sampler.region_colors_from_columns(columns, regions=3)
+        exp_regions, exp_weights = self.sampler.weighted_mean_color_regions(hsv, img_cropped, regions=3)
+        for got, want in zip(regions, exp_regions):
+            self.assertTrue(np.allclose(got, want, atol=1.0))
+        self.assertTrue(np.allclose(weights, exp_weights, rtol=0.02))
+
+    def test_cropped_band_matches_full_frame(self):
+        # capture_bgra() reads back only the rows under the uncropped cells.
+        rng = np.random.default_rng(3)
+        bgra = rng.integers(0, 256, size=(144, 256, 4), dtype=np.uint8)
+        full = self.sampler.sample_columns(bgra.tobytes(), 256, 144).copy()
+        top, bottom = self.sampler._crop_rows()
+        y0, y1 = top * 144 // 36, bottom * 144 // 36
+        band = self.sampler.sample_columns(bgra[y0:y1].tobytes(), 256, 144, first_row=y0)
+        self.assertTrue(np.array_equal(full, band))
+
+    def test_rejects_short_buffer(self):
+        with self.assertRaises(ValueError):
+            self.sampler.sample_columns(bytes(100), 256, 144)
+
 class TestAudioFFT(unittest.TestCase):
     def setUp(self):
         # Avoid opening real audio devices during unit tests.
@@ -58,6 +95,42 @@ class TestAudioFFT(unittest.TestCase):
         energy = self.audio.get_audio_energy()
         self.assertEqual(energy, 0.0)
 
+class TestNativeAudioTap(unittest.TestCase):
+    def setUp(self):
+        import native
+        if native.ext is None:
+            self.skipTest('native extension not built')
+        self.ext = native.ext
+
+    def test_features_match_numpy_path(self):
+        sr, n = 44100.0, 2048
+        t = np.arange(5000) / sr
+        mono = (np.sin(2 * np.pi * 90 * t) + 0.4 * np.sin(2 * np.pi * 700 * t)).astype(np.float32)
+        stereo = np.stack([mono, mono], axis=1)
+        tap = self.ext.AudioTap(n, sr)
+        self.assertIsNone(tap.analyze())
+        for i in range(0, len(stereo), 512):
+            tap.write(stereo[i:i + 512])
+        low, mid, centroid, fresh = tap.analyze()
+        self.assertEqual(fresh, len(mono))
+        fft = np.abs(np.fft.fft(mono[-n:].astype(np.float64)))[: n // 2]
+        freqs = np.fft.fftfreq(n, 1 / sr)[: n // 2]
+        self.assertAlmostEqual(low, float(np.sum(fft[(freqs >= 20) & (freqs < 150)])), delta=1e-3)
+        self.assertAlmostEqual(mid, float(np.sum(fft[(freqs >= 150) & (freqs < 2000)])), delta=1e-3)
+        self.assertAlmostEqual(centroid, float(np.sum(freqs * fft) / (np.sum(fft) + 1e-9)), delta=1e-3)
+        self.assertEqual(tap.analyze()[3], 0)
+
+    def test_callback_feeds_features(self):
+        with mock.patch.object(AudioFFT, '_init_stream', lambda self: None):
+            audio = AudioFFT()
+        audio._tap = self.ext.AudioTap(audio.buffer_size, audio.sample_rate)
+        audio.stream = mock.Mock(active=True)
+        t = np.arange(audio.buffer_size) / audio.sample_rate
+        block = np.sin(2 * np.pi * 100 * t).astype(np.float32).reshape(-1, 1)
+        audio._audio_callback(block, len(block), None, None)
+        features = audio.get_audio_features()
+        self.assertGreater(features['bass'], features['mid'])
+
 class TestPacketBuilder(unittest.TestCase):
     def setUp(self):
         self.config = Config()
@@ -84,5 +157,336 @@ class TestPacketBuilder(unittest.TestCase):
             checksum ^= b
         self.assertEqual(packet[10], checksum)
 
+    def test_packet_v2_format(self):
+        import binascii
+        import struct
+        self.config.udp_protocol_version = 2
+        data = {
+            'mode': 2,
+            'base_color': [10, 20, 30],
+            'brightness': 80,
+            'motion_energy': 100,
+            'motion_speed': 0.5,
+            'direction': 224,
+            'seq': 0x1234,
+            'sender_ms': 0x89ABCDEF,
+        }
+        packet = self.builder.build(data)
+        self.assertEqual(len(packet), 19)
+        self.assertEqual(packet[0], 0xA5)
+        self.assertEqual(packet[1], 2)
+        self.assertEqual(list(packet[3:11]), [2, 10, 20, 30, 80, 100, 50, 224])
+        seq, sender_ms, crc = struct.unpack('<HIH', packet[11:19])
+        self.assertEqual(seq, 0x1234)
+        self.assertEqual(sender_ms, 0x89ABCDEF)
+        # CRC-16/CCITT-FALSE over everything before the CRC
+        self.assertEqual(crc, binascii.crc_hqx(packet[:17], 0xFFFF))
+
+    def test_packet_v2_seq_falls_back_to_frame_id(self):
+        self.config.udp_protocol_version = 2
+        packet = self.builder.build({'frame_id': 9, 'sender_ms': 0})
+        self.assertEqual(packet[11], 9)
+        self.assertEqual(packet[12], 0)
+
+    def test_packet_v2_sync_extension(self):
+        import binascii
+        import struct
+        self.config.udp_protocol_version = 2
+        self.config.sync_present_delay_ms = 60
+        packet = self.builder.build({'mode': 1, 'seq': 5, 'sender_ms': 1000})
+        self.assertEqual(len(packet), 20)
+        self.assertEqual(packet[2], 0x02)
+        self.assertEqual(packet[17], 60)
+        self.assertEqual(struct.unpack('<H', packet[18:20])[0], binascii.crc_hqx(packet[:18], 0xFFFF))
+
+    def test_packet_v2_beat_extension(self):
+        import binascii
+        import struct
+        self.config.udp_protocol_version = 2
+        packet = self.builder.build({'mode': 2, 'seq': 5, 'sender_ms': 1000, 'beat': (7, 0.5, 960.0)})
+        self.assertEqual(len(packet), 22)
+        self.assertEqual(packet[2], 0x04)
+        self.assertEqual(list(packet[17:20]), [7, 128, 40])
+        self.assertEqual(struct.unpack('<H', packet[20:22])[0], binascii.crc_hqx(packet[:20], 0xFFFF))
+        # Too old to matter: dropped rather than flashed late.
+        stale = self.builder.build({'mode': 2, 'seq': 6, 'sender_ms': 1500, 'beat': (7, 0.5, 960.0)})
+        self.assertEqual(len(stale), 19)
+
+    def test_raw_frame_splits_into_ddp_packets(self):
+        import struct
+        pixels = np.zeros((600, 3), dtype=np.uint8)
+        pixels[:, 0] = np.arange(600) % 256
+        packets = self.builder.build_raw_frame(pixels, seq=0)
+        self.assertEqual(len(packets), 2)
+        offsets = []
+        for i, pkt in enumerate(packets):
+            flags, seq, dtype, dest, offset, length = struct.unpack('>BBBBIH', pkt[:10])
+            self.assertEqual(flags & 0xC0, 0x40)
+            self.assertEqual(flags & 0x01, 1 if i == len(packets) - 1 else 0)
+            self.assertEqual(seq, 1)
+            self.assertEqual(length, len(pkt) - 10)
+            offsets.append(offset)
+        self.assertEqual(offsets, [0, 1440])
+        frame = b''.join(pkt[10:] for pkt in packets)
+        self.assertEqual(frame, pixels.tobytes())
+
+class TestTelemetryClient(unittest.TestCase):
+    def test_stats_reply_round_trip(self):
+        import struct
+        from packet_builder import crc16_ccitt
+        from telemetry_client import build_stats_request, parse_stats_reply
+        self.assertEqual(build_stats_request(reset=True), bytes([0xA6, 0x01, 0x01]))
+        counters = list(range(12))
+        body = struct.pack('<BBBBBI', 0xA6, 0x81, 1, len(counters), 4, 123456)
+        body += struct.pack('<12I', *counters)
+        for i in range(4):
+            body += struct.pack('<5I', 100 + i, 1, 5, 40, 30)
+        reply = body + struct.pack('<H', crc16_ccitt(body))
+        stats = parse_stats_reply(reply)
+        self.assertEqual(stats['uptime_ms'], 123456)
+        self.assertEqual(stats['counters']['lost'], 3)
+        self.assertEqual(stats['counters']['raw_frames'], 11)
+        self.assertEqual(stats['timings']['show'], {'count': 103, 'min_us': 1, 'avg_us': 5, 'max_us': 40, 'p99_us': 30})
+        corrupted = bytearray(reply)
+        corrupted[10] ^= 0xFF
+        self.assertIsNone(parse_stats_reply(bytes(corrupted)))
+
+class TestColorLutClient(unittest.TestCase):
+    def test_lut_request_layout(self):
+        import struct
+        from packet_builder import crc16_ccitt
+        from color_lut_client import build_lut, build_lut_request, parse_lut_reply
+        table = build_lut(gamma=2.2, white=(255, 128, 200))
+        self.assertEqual(len(table), 768)
+        self.assertEqual(table[255], 255)
+        self.assertEqual(table[256 + 255], 128)
+        self.assertEqual(table[512 + 255], 200)
+        self.assertEqual(table[0], 0)
+        self.assertLess(table[128], 128)  # gamma > 1 darkens midtones
+        req = build_lut_request(1, table, persist=True)
+        self.assertEqual(list(req[:4]), [0xA6, 0x03, 0x01, 1])
+        self.assertEqual(len(req), 4 + 768 + 2)
+        self.assertEqual(struct.unpack_from('<H', req, len(req) - 2)[0], crc16_ccitt(req[:-2]))
+        self.assertEqual(list(build_lut_request(0, None, persist=True)[:4]), [0xA6, 0x03, 0x03, 0])
+        self.assertEqual(parse_lut_reply(bytes([0xA6, 0x83, 2])), 2)
+        self.assertIsNone(parse_lut_reply(bytes([0xA6, 0x81, 0])))
+        with self.assertRaises(ValueError):
+            build_lut_request(0, b'\x00' * 10)
+
+class TestSceneClient(unittest.TestCase):
+    def test_scene_request_layout(self):
+        import struct
+        from packet_builder import crc16_ccitt
+        from scene_client import build_scene_record, build_scene_request, parse_scene_reply
+        rec = build_scene_record('sunrise', color1=(60, 10, 0), color2=(255, 200, 140), minutes=20)
+        self.assertEqual(list(rec), [3, 0, 110, 21, 16, 20, 60, 10, 0, 255, 200, 140])
+        self.assertEqual(build_scene_record('breathe', last_color=True)[1], 0x01)
+        req = build_scene_request([rec, build_scene_record('noise')], active=1, persist=True)
+        self.assertEqual(list(req[:5]), [0xA6, 0x04, 0x01, 1, 2])
+        self.assertEqual(len(req), 5 + 2 * 12 + 2)
+        self.assertEqual(struct.unpack_from('<H', req, len(req) - 2)[0], crc16_ccitt(req[:-2]))
+        self.assertEqual(len(build_scene_request([], active=2)), 7)
+        self.assertEqual(parse_scene_reply(bytes([0xA6, 0x84, 1])), 1)
+        self.assertIsNone(parse_scene_reply(bytes([0xA6, 0x83, 0])))
+        with self.assertRaises(ValueError):
+            build_scene_record(9)
+        with self.assertRaises(ValueError):
+            build_scene_request([rec] * 5)
+
+class TestCapture(unittest.TestCase):
+    def test_capture_round_trip(self):
+        import tempfile
+        from capture import CHANNEL_CONTROL, CHANNEL_DDP, CaptureWriter, read_capture
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, 'session.alcap')
+            writer = CaptureWriter(path)
+            writer.write(b'\xaa' + bytes(10) + b'\x55', t_ms=0)
+            writer.write(bytes(range(40)), t_ms=40, channel=CHANNEL_DDP)
+            writer.close()
+            with open(path, 'rb') as f:
+                self.assertEqual(f.read(8), b'ALCAP1\x00\x00')
+            records = list(read_capture(path))
+        self.assertEqual([(t, ch, len(d)) for t, ch, d in records], [(0, CHANNEL_CONTROL, 12), (40, CHANNEL_DDP, 40)])
+        self.assertEqual(records[1][2], bytes(range(40)))
+
+    def test_udp_sender_records_sent_packets(self):
+        import tempfile
+        from capture import read_capture
+        from udp_sender import UDPSender
+        with tempfile.TemporaryDirectory() as tmp:
+            cfg = Config()
+            cfg.capture_path = os.path.join(tmp, 'sent.alcap')
+            sender = UDPSender(cfg)
+            sender.sock = mock.Mock()
+            sender.send(b'\x01\x02\x03')
+            sender.capture.close()
+            records = list(read_capture(cfg.capture_path))
+        self.assertEqual(len(records), 1)
+        self.assertEqual(records[0][2], b'\x01\x02\x03')
+        sender.sock.sendto.assert_called_once()
+
+class TestConfig(unittest.TestCase):
+    def test_defaults_are_consistent(self):
+        self.assertEqual(Config().validate(), [])
+
+    def test_v2_features_on_v1_warn(self):
+        cfg = Config()
+        cfg.udp_protocol_version = 1
+        cfg.enable_audio_beats = True
+        cfg.zone_count = 8
+        cfg.sync_present_delay_ms = 60
+        warnings = cfg.validate()
+        self.assertEqual(len(warnings), 3)
+        self.assertIn('enable_audio_beats needs udp_protocol_version = 2', warnings[0])
+        self.assertTrue(warnings[1].startswith('zone_count'))
+        self.assertTrue(warnings[2].startswith('sync_present_delay_ms'))
+
+    def test_v2_features_on_v2_are_quiet(self):
+        cfg = Config()
+        cfg.udp_protocol_version = 2
+        cfg.enable_audio_beats = True
+        cfg.zone_count = 8
+        cfg.sync_present_delay_ms = 60
+        self.assertEqual(cfg.validate(), [])
+
+    def test_sender_logs_warnings(self):
+        from udp_sender import UDPSender
+        cfg = Config()
+        cfg.udp_protocol_version = 1
+        cfg.enable_audio_beats = True
+        with mock.patch('udp_sender.socket.socket'), mock.patch('builtins.print') as out:
+            UDPSender(cfg)
+        out.assert_any_call('[CONFIG] enable_audio_beats needs udp_protocol_version = 2; '
+                            'protocol 1 packets do not carry it')
+
+class TestUDPSender(unittest.TestCase):
+    def _sender(self, ip):
+        import socket
+        from udp_sender import UDPSender
+        cfg = Config()
+        cfg.udp_ip = ip
+        with mock.patch('udp_sender.socket.socket') as sock_cls:
+            sender = UDPSender(cfg)
+        calls = sock_cls.return_value.setsockopt.call_args_list
+        return sender, [c.args[:2] for c in calls], socket
+
+    def test_multicast_target_sets_ttl(self):
+        _, opts, socket = self._sender('239.10.42.1')
+        self.assertIn((socket.SOL_SOCKET, socket.SO_BROADCAST), opts)
+        self.assertIn((socket.IPPROTO_IP, socket.IP_MULTICAST_TTL), opts)
+
+    def test_unicast_target_leaves_multicast_options(self):
+        _, opts, socket = self._sender('192.168.0.100')
+        self.assertNotIn((socket.IPPROTO_IP, socket.IP_MULTICAST_TTL), opts)
+
+    def test_one_send_per_frame(self):
+        sender, _, _ = self._sender('239.10.42.1')
+        sender.sock = mock.Mock()
+        sender.send(b'\x01')
+        sender.sock.sendto.assert_called_once_with(b'\x01', ('239.10.42.1', 4210))
+
+    def test_pacer_sends_submitted_packet(self):
+        import socket
+        import native
+        from udp_sender import UDPSender
+        if native.ext is None:
+            self.skipTest('native extension not built')
+        rx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.addCleanup(rx.close)
+        rx.bind(('127.0.0.1', 0))
+        rx.settimeout(1.0)
+        cfg = Config()
+        cfg.udp_ip = '127.0.0.1'
+        cfg.udp_port = rx.getsockname()[1]
+        cfg.udp_rate_hz = 50
+        sender = UDPSender(cfg)
+        self.addCleanup(sender.close)
+        self.assertTrue(sender.start_pacer())
+        deadline_ms, wait_s = sender.pacer.next_slot()
+        self.assertLessEqual(wait_s, 0.02 + 1e-3)
+        sender.send(b'paced')
+        self.assertEqual(rx.recv(64), b'paced')
+        self.assertEqual(sender.pacer.stats()['replaced'], 0)
+
+class TestOnsetDetector(unittest.TestCase):
+    def test_step_is_an_onset_once_per_refractory(self):
+        from signal_processing import OnsetDetector
+        det = OnsetDetector(threshold=1.6, min_flux=8.0, refractory_ms=120, full_scale=160)
+        t = 0.0
+        for _ in range(50):
+            self.assertIsNone(det.update(20.0, 12.0, t))  # steady level
+            t += 12.0
+        strength = det.update(100.0, 12.0, t)
+        self.assertAlmostEqual(strength, 0.5)
+        self.assertIsNone(det.update(20.0, 12.0, t + 12.0))
+        self.assertIsNone(det.update(100.0, 12.0, t + 24.0))  # inside the refractory window
+        self.assertIsNone(det.update(20.0, 12.0, t + 200.0))
+        self.assertIsNotNone(det.update(120.0, 12.0, t + 212.0))
+
+    def test_slow_swell_is_not_an_onset(self):
+        from signal_processing import OnsetDetector
+        det = OnsetDetector()
+        hits = [det.update(2.0 * i, 12.0, 12.0 * i) for i in range(80)]
+        self.assertEqual([h for h in hits if h is not None], [])
+
+class TestRateController(unittest.TestCase):
+    def setUp(self):
+        from rate_controller import RateController
+        self.cfg = Config()
+        self.cfg.udp_adaptive_rate = True
+        self.rate = RateController(self.cfg)
+        self.data = {'mode': 1, 'base_color': [100, 50, 20], 'zone_colors': None,
+                     'screen_motion_energy': 0.0, 'audio_motion_energy': 0.0}
+        self.assertTrue(self.rate.due(self.data, 0.0))
+        self.rate.start_packet(self.data, 0.0)
+
+    def test_static_scene_sends_keepalives_under_fallback_timeout(self):
+        self.assertFalse(self.rate.due(self.data, 0.3))
+        self.assertTrue(self.rate.due(self.data, self.rate.keepalive_s))
+        self.assertLess(self.rate.keepalive_s, 1.8)
+
+    def test_fast_change_uses_max_rate(self):
+        self.data['base_color'] = [140, 50, 20]
+        poll = self.rate.poll_interval_s
+        self.assertAlmostEqual(poll, 1.0 / self.cfg.udp_max_rate_hz)
+        self.assertTrue(self.rate.due(self.data, poll))
+
+    def test_small_change_uses_base_rate_or_faster(self):
+        self.data['screen_motion_energy'] = 1.5
+        self.assertFalse(self.rate.due(self.data, 0.005))
+        self.assertTrue(self.rate.due(self.data, 1.0 / self.cfg.udp_rate_hz))
+
+    def test_mode_change_is_immediate(self):
+        self.data['mode'] = 2
+        self.assertTrue(self.rate.due(self.data, 0.001))
+
+    def test_new_beat_is_immediate_in_audio_modes(self):
+        from rate_controller import RateController
+        self.cfg.udp_protocol_version = 2
+        rate = RateController(self.cfg)
+        self.data['mode'] = 2
+        self.data['audio_beat_id'] = 1
+        rate.start_packet(self.data, 0.0)
+        self.assertFalse(rate.due(self.data, 0.01))
+        self.data['audio_beat_id'] = 2
+        self.assertTrue(rate.due(self.data, 0.01))
+
+    def test_new_beat_waits_under_protocol_v1(self):
+        # v1 packets carry no beat, so a new beat id is not worth an early send.
+        self.cfg.udp_protocol_version = 1
+        self.data['mode'] = 2
+        self.data['audio_beat_id'] = 1
+        self.rate.start_packet(self.data, 0.0)
+        self.data['audio_beat_id'] = 2
+        self.assertFalse(self.rate.due(self.data, 0.01))
+
+    def test_fixed_rate_when_disabled(self):
+        from rate_controller import RateController
+        self.cfg.udp_adaptive_rate = False
+        rate = RateController(self.cfg)
+        rate.start_packet(self.data, 0.0)
+        self.assertEqual(rate.send_rate_hz, self.cfg.udp_rate_hz)
+        self.assertTrue(rate.due(self.data, 1.0 / self.cfg.udp_rate_hz))
+
 if __name__ == "__main__":
     unittest.main()
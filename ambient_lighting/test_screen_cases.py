@@ -95,6 +95,17 @@ class TestScreenAlgorithmSynthetic(unittest.TestCase):
         self.assertIsNotNone(region_colors[0])
         self.assertTrue(np.allclose(region_colors[0], np.array([0, 128, 0], dtype=np.float32), atol=10.0))
 
+    def test_zone_colors_follow_screen_columns(self):
+        img = _make_split_frame([0, 128, 0], [0, 0, 0], [0, 0, 128], w=64)
+        hsv, cropped = self.sampler.process_image(img)
+        fallback = np.array([1, 2, 3], dtype=np.float32)
+        zones = self.sampler.zone_colors(hsv, cropped, 8, fallback)
+        self.assertEqual(zones.shape, (8, 3))
+        self.assertTrue(np.allclose(zones[0], [0, 128, 0], atol=10.0))
+        self.assertTrue(np.allclose(zones[-1], [0, 0, 128], atol=10.0))
+        # Black center columns have no usable pixels and take the fallback color.
+        self.assertTrue(np.allclose(zones[3], fallback, atol=1e-3))
+
     def test_random_frames_never_nan_and_in_range(self):
         rng = np.random.default_rng(123)
         for _ in range(200):
@@ -191,6 +202,24 @@ class TestModePacketsSynthetic(unittest.TestCase):
         self.assertEqual(list(p[2:5]), [200, 10, 30])
         self.assertEqual(int(p[6]), 77)
 
+    def test_v2_zone_payload_only_in_screen_modes(self):
+        self.cfg.udp_protocol_version = 2
+        self.cfg.zone_count = 4
+        zones = np.array([[10, 20, 30], [40, 50, 60], [70, 80, 90], [100, 110, 120]], dtype=np.float32)
+        data = {'mode': 1, 'base_color': [1, 2, 3], 'zone_colors': zones, 'direction': 128}
+        pkt = self.mm.build_packet(dict(data))
+        self.assertEqual(pkt[2] & 0x01, 0x01)
+        self.assertEqual(pkt[17], 4)
+        self.assertEqual(list(pkt[18:30]), [10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120])
+        self.assertEqual(len(pkt), 19 + 1 + 12)
+
+        data['mode'] = 2
+        data['audio_motion_energy'] = 0.0
+        with mock.patch('time.time', return_value=1.0):
+            pkt = self.mm.build_packet(dict(data))
+        self.assertEqual(pkt[2] & 0x01, 0)
+        self.assertEqual(len(pkt), 19)
+
     def test_mode5_off_is_black_and_zero_brightness(self):
         data = {'mode': 5, 'base_color': [255, 255, 255], 'screen_motion_energy': 180}
         with mock.patch('time.time', return_value=0.0):
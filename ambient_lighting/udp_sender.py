@@ -4,14 +4,65 @@ Sends UDP packets to ESP32 for ambient lighting.
 Strictly follows PROJECT_SPEC.md.
 """
 
+import ipaddress
 import socket
 
+from capture import CHANNEL_CONTROL, CHANNEL_DDP, CaptureWriter
+
+try:
+    from native import ext as native_ext
+except ImportError:
+    native_ext = None
+
 
 class UDPSender:
     def __init__(self, config):
         self.config = config
+        validate = getattr(config, 'validate', None)
+        for warning in (validate() if validate else []):
+            print(f"[CONFIG] {warning}")
         self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self._configure_fanout()
         self._last_debug_print = 0.0
+        # Optional ALCAP1 recording of everything sent (for firmware/host replay).
+        path = getattr(config, 'capture_path', None)
+        self.capture = CaptureWriter(path) if path else None
+        self.pacer = None
+
+    def start_pacer(self, rate_hz=None):
+        """
+        Hand control packets to the native pacer, which sends the newest one on every
+        1/rate_hz (default udp_rate_hz) deadline from its own thread. Returns False (send() keeps sending
+        immediately) when the module is not built or the target cannot be resolved.
+        """
+        if native_ext is None:
+            return False
+        try:
+            host = socket.gethostbyname(self.config.udp_ip)
+            rate_hz = float(rate_hz or self.config.udp_rate_hz)
+            self.pacer = native_ext.PacketPacer(host, int(self.config.udp_port), rate_hz,
+                                                int(getattr(self.config, 'udp_multicast_ttl', 1)))
+        except (OSError, ValueError) as e:
+            print(f"UDP pacer unavailable: {e}")
+            self.pacer = None
+        return self.pacer is not None
+
+    def close(self):
+        if self.pacer is not None:
+            self.pacer.close()
+            self.pacer = None
+        self.sock.close()
+
+    def _configure_fanout(self):
+        # Broadcast and multicast targets reach every unit with one send (Config.udp_ip).
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+        try:
+            multicast = ipaddress.ip_address(self.config.udp_ip).is_multicast
+        except ValueError:
+            multicast = False  # host name
+        if multicast:
+            ttl = int(getattr(self.config, 'udp_multicast_ttl', 1))
+            self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, ttl)
 
     def send(self, packet):
         # Optional debug print (rate-limited)
@@ -23,7 +74,24 @@ class UDPSender:
                 print("UDP Packet:", packet)
                 self._last_debug_print = now
 
+        if self.capture:
+            self.capture.write(packet, channel=CHANNEL_CONTROL)
         try:
+            if self.pacer is not None:
+                self.pacer.submit(packet)  # goes out on the pacer's next deadline
+                return
             self.sock.sendto(packet, (self.config.udp_ip, self.config.udp_port))
         except Exception as e:
             print(f"UDP send failed: {e}")
+
+    def send_raw_frame(self, packets):
+        """Send the DDP datagrams of one frame (PacketBuilder.build_raw_frame) back to back."""
+        port = int(getattr(self.config, 'ddp_port', 4048))
+        if self.capture:
+            for packet in packets:
+                self.capture.write(packet, channel=CHANNEL_DDP)
+        try:
+            for packet in packets:
+                self.sock.sendto(packet, (self.config.udp_ip, port))
+        except Exception as e:
+            print(f"UDP raw frame send failed: {e}")
@@ -0,0 +1,114 @@
+// bench.cpp
+// Runner for bench.h: --filter=<substr> --min-time=<s> --quick --json=<path>
+#include "bench.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace bench {
+
+struct Registered {
+    std::string name;
+    std::function<void(State &)> fn;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations;
+    double wallNsPerIter;
+    double cpuNsPerIter;
+    double itemsPerSecond;
+};
+
+static std::vector<Registered> &registry() {
+    static std::vector<Registered> benchmarks;
+    return benchmarks;
+}
+
+int registerBenchmark(const char *name, std::function<void(State &)> fn) {
+    registry().push_back(Registered{name, fn});
+    return int(registry().size());
+}
+
+// Grow the iteration count until one run lasts at least minTimeS, then report that run.
+static Result runOne(const Registered &b, double minTimeS) {
+    const double minNs = minTimeS * 1e9;
+    uint64_t iterations = 1;
+    for (;;) {
+        State state(iterations);
+        b.fn(state);
+        const double ns = std::max(state.wallNs(), 1.0);
+        if (ns >= minNs || iterations >= 1000000000ULL) {
+            Result r;
+            r.name = b.name;
+            r.iterations = iterations;
+            r.wallNsPerIter = state.wallNs() / double(iterations);
+            r.cpuNsPerIter = state.cpuNs() / double(iterations);
+            r.itemsPerSecond = state.itemsPerIteration()
+                                   ? double(state.itemsPerIteration()) * double(iterations) * 1e9 / ns
+                                   : 0.0;
+            return r;
+        }
+        double scale = std::min(10.0, std::max(1.5, minNs * 1.4 / ns));
+        iterations = uint64_t(double(iterations) * scale) + 1;
+    }
+}
+
+static bool writeJson(const char *path, const char *executable, const std::vector<Result> &results) {
+    FILE *f = std::fopen(path, "w");
+    if (!f) return false;
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    std::fprintf(f, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": \"%s\"\n  },\n",
+                 date, executable);
+    std::fprintf(f, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        std::fprintf(f,
+                     "    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %llu, "
+                     "\"real_time\": %.3f, \"cpu_time\": %.3f, \"time_unit\": \"ns\"",
+                     r.name.c_str(), (unsigned long long)r.iterations, r.wallNsPerIter, r.cpuNsPerIter);
+        if (r.itemsPerSecond > 0.0) std::fprintf(f, ", \"items_per_second\": %.1f", r.itemsPerSecond);
+        std::fprintf(f, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+int runMain(int argc, char **argv) {
+    double minTimeS = 0.2;
+    const char *filter = nullptr;
+    const char *jsonPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) filter = argv[i] + 9;
+        else if (std::strncmp(argv[i], "--min-time=", 11) == 0) minTimeS = std::atof(argv[i] + 11);
+        else if (std::strcmp(argv[i], "--quick") == 0) minTimeS = 0.005;
+        else if (std::strncmp(argv[i], "--json=", 7) == 0) jsonPath = argv[i] + 7;
+        else {
+            std::fprintf(stderr, "usage: %s [--filter=<substr>] [--min-time=<s>] [--quick] [--json=<path>]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Result> results;
+    std::printf("%-36s %14s %14s %14s\n", "Benchmark", "Time (ns)", "Iterations", "Items/s");
+    for (const Registered &b : registry()) {
+        if (filter && b.name.find(filter) == std::string::npos) continue;
+        Result r = runOne(b, minTimeS);
+        std::printf("%-36s %14.1f %14llu", r.name.c_str(), r.wallNsPerIter, (unsigned long long)r.iterations);
+        if (r.itemsPerSecond > 0.0) std::printf(" %14.3g", r.itemsPerSecond);
+        std::printf("\n");
+        results.push_back(r);
+    }
+    if (jsonPath && !writeJson(jsonPath, argv[0], results)) {
+        std::fprintf(stderr, "failed to write %s\n", jsonPath);
+        return 1;
+    }
+    return results.empty() ? 1 : 0;
+}
+
+} // namespace bench
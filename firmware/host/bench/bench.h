@@ -0,0 +1,67 @@
+// bench.h
+// Minimal Google Benchmark-style runner: registered benchmarks, auto-calibrated iteration
+// counts, a console table and JSON output in the same "benchmarks" schema.
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+
+namespace bench {
+
+class State {
+public:
+    explicit State(uint64_t iterations) : iterations_(iterations), remaining_(iterations) {}
+
+    // `while (state.keepRunning()) { ... }` times exactly iterations() passes.
+    bool keepRunning() {
+        if (!started_) {
+            started_ = true;
+            cpuStart_ = std::clock();
+            wallStart_ = std::chrono::steady_clock::now();
+        }
+        if (remaining_ == 0) {
+            wallNs_ = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - wallStart_).count());
+            cpuNs_ = double(std::clock() - cpuStart_) * 1e9 / CLOCKS_PER_SEC;
+            return false;
+        }
+        --remaining_;
+        return true;
+    }
+
+    uint64_t iterations() const { return iterations_; }
+    double wallNs() const { return wallNs_; }
+    double cpuNs() const { return cpuNs_; }
+
+    // Units of work per iteration (e.g. LEDs per frame, bytes per packet) for throughput.
+    void setItemsPerIteration(uint64_t n) { itemsPerIteration_ = n; }
+    uint64_t itemsPerIteration() const { return itemsPerIteration_; }
+
+private:
+    uint64_t iterations_;
+    uint64_t remaining_;
+    bool started_ = false;
+    std::clock_t cpuStart_ = 0;
+    std::chrono::steady_clock::time_point wallStart_;
+    double wallNs_ = 0.0;
+    double cpuNs_ = 0.0;
+    uint64_t itemsPerIteration_ = 0;
+};
+
+int registerBenchmark(const char *name, std::function<void(State &)> fn);
+int runMain(int argc, char **argv);
+
+// Keep a computed value (and everything it depends on) from being optimized away.
+template <class T> inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+} // namespace bench
+
+#define BENCHMARK(fn) static int fn##_registration = ::bench::registerBenchmark(#fn, fn)
@@ -0,0 +1,294 @@
+// kernel_bench.cpp
+// Host timings for the firmware hot paths: mode kernels (ns per frame), packet -> state
+// update, and packet parsing for valid and corrupt datagrams.
+#include "config.h"
+#include "bench.h"
+#include "color_lut.h"
+#include "dither.h"
+#include "host_runtime.h"
+#include "jitter_buffer.h"
+#include "modes.h"
+#include "power_meter.h"
+#include "protocol.h"
+#include "state.h"
+#include <vector>
+
+static const unsigned long kFrameMs = 8;
+static const unsigned long kPacketMs = 40;
+
+static void putU16(uint8_t *p, uint16_t v) {
+    p[0] = uint8_t(v);
+    p[1] = uint8_t(v >> 8);
+}
+
+static void putU32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = uint8_t(v >> (8 * i));
+}
+
+static std::vector<uint8_t> makeV1(uint8_t mode, uint8_t frameId) {
+    std::vector<uint8_t> buf = {0xAA, mode, 180, 90, 40, 200, 120, 60, 128, frameId, 0, 0x55};
+    for (int i = 1; i <= 9; ++i) buf[10] ^= buf[i];
+    return buf;
+}
+
+static std::vector<uint8_t> makeV2(uint8_t mode, uint16_t seq, uint32_t senderMs, uint8_t zones) {
+    std::vector<uint8_t> buf = {PACKET_V2_MAGIC, PACKET_V2_VERSION, uint8_t(zones ? PACKET_FLAG_ZONES : 0),
+                                mode, 180, 90, 40, 200, 120, 60, 128};
+    buf.resize(17);
+    putU16(&buf[11], seq);
+    putU32(&buf[13], senderMs);
+    if (zones) {
+        buf.push_back(zones);
+        for (uint8_t z = 0; z < zones; ++z) {
+            buf.push_back(uint8_t(z * 8));
+            buf.push_back(uint8_t(255 - z * 8));
+            buf.push_back(64);
+        }
+    }
+    buf.resize(buf.size() + 2);
+    putU16(&buf[buf.size() - 2], crc16(buf.data(), buf.size() - 2));
+    return buf;
+}
+
+// Drive the real state path into a steady mid-motion state for `mode`.
+static void primeState(uint8_t mode, uint8_t zones) {
+    static bool modesReady = false;
+    if (!modesReady) {
+        initModes();
+        modesReady = true;
+    }
+    hostSetMillis(1000);
+    initState();
+    Packet packet;
+    for (uint16_t seq = 0; seq < 4; ++seq) {
+        std::vector<uint8_t> buf = makeV2(mode, seq, 1000 + seq * kPacketMs, zones);
+        parsePacket(buf.data(), buf.size(), packet);
+        hostAdvanceMillis(kPacketMs);
+        updateStateFromPacket(packet, millis());
+    }
+    snapRenderStateToTarget(false);
+    renderState.render_motion_energy = 120.0f;
+}
+
+static void runKernel(bench::State &state, void (*kernel)()) {
+    while (state.keepRunning()) {
+        advanceRenderPhase(kFrameMs / 1000.0f, kPacketMs / 1000.0f);
+        kernel();
+        bench::doNotOptimize(leds[NUM_LEDS / 2]);
+        bench::clobberMemory();
+    }
+    state.setItemsPerIteration(NUM_LEDS);
+}
+
+static void BM_RenderMode1(bench::State &state) {
+    primeState(1, 0);
+    runKernel(state, renderMode1);
+}
+BENCHMARK(BM_RenderMode1);
+
+static void BM_RenderMode1Zones16(bench::State &state) {
+    primeState(1, 16);
+    runKernel(state, renderMode1);
+}
+BENCHMARK(BM_RenderMode1Zones16);
+
+static void BM_RenderMode2(bench::State &state) {
+    primeState(2, 0);
+    runKernel(state, renderMode2);
+}
+BENCHMARK(BM_RenderMode2);
+
+static void BM_RenderMode3(bench::State &state) {
+    primeState(3, 0);
+    runKernel(state, renderMode3);
+}
+BENCHMARK(BM_RenderMode3);
+
+static void BM_RenderMode4(bench::State &state) {
+    primeState(4, 0);
+    runKernel(state, renderMode4);
+}
+BENCHMARK(BM_RenderMode4);
+
+static void BM_RenderMode5(bench::State &state) {
+    primeState(5, 0);
+    runKernel(state, renderMode5);
+}
+BENCHMARK(BM_RenderMode5);
+
+// Worst case for a transition frame: fade from Mode 1 into Mode 3 (two kernels, one blended).
+static void BM_RenderFrameCrossFade(bench::State &state) {
+    primeState(1, 0);
+    renderFrame();
+    targetState.mode = 3;
+    while (state.keepRunning()) {
+        beginTransition();
+        hostAdvanceMillis(kFrameMs);
+        renderFrame();
+        bench::doNotOptimize(leds[NUM_LEDS / 2]);
+        bench::clobberMemory();
+    }
+    state.setItemsPerIteration(NUM_LEDS);
+}
+BENCHMARK(BM_RenderFrameCrossFade);
+
+// renderFrame() meters the kernel's writes for the power limiter; compare with BM_RenderMode1.
+static void BM_RenderFrameMode1Metered(bench::State &state) {
+    primeState(1, 0);
+    renderFrame();
+    while (state.keepRunning()) {
+        advanceRenderPhase(kFrameMs / 1000.0f, kPacketMs / 1000.0f);
+        hostAdvanceMillis(kFrameMs);
+        renderFrame();
+        bench::doNotOptimize(leds[NUM_LEDS / 2]);
+        bench::clobberMemory();
+    }
+    state.setItemsPerIteration(NUM_LEDS);
+}
+BENCHMARK(BM_RenderFrameMode1Metered);
+
+// The separate pass the metered kernels avoid (still used for raw stream frames).
+static void BM_PowerMeasurePass(bench::State &state) {
+    primeState(1, 0);
+    renderMode1();
+    PowerMeter meter;
+    while (state.keepRunning()) {
+        meter.measure(leds);
+        bench::doNotOptimize(meter.sums().ch[0][1]);
+        bench::clobberMemory();
+    }
+    state.setItemsPerIteration(NUM_LEDS);
+}
+BENCHMARK(BM_PowerMeasurePass);
+
+// Output stage: one gamma/white-balance lookup per channel over the whole strip.
+static void BM_ApplyColorLut(bench::State &state) {
+    primeState(1, 0);
+    renderMode1();
+    ColorLut lut;
+    buildColorLut(lut, 2.2f, 255, 200, 230);
+    static CRGB wire[NUM_LEDS];
+    while (state.keepRunning()) {
+        applyColorLut(lut, leds, wire, NUM_LEDS);
+        bench::doNotOptimize(wire[NUM_LEDS / 2]);
+        bench::clobberMemory();
+    }
+    state.setItemsPerIteration(NUM_LEDS);
+}
+BENCHMARK(BM_ApplyColorLut);
+
+// The same pass with the frame brightness folded in and error-diffused (ENABLE_TEMPORAL_DITHER).
+static void BM_ApplyColorLutDithered(bench::State &state) {
+    primeState(1, 0);
+    renderMode1();
+    ColorLut lut;
+    buildColorLut(lut, 2.2f, 255, 200, 230);
+    static CRGB wire[NUM_LEDS];
+    static DitherResidual residual;
+    initDitherResidual(residual);
+    const uint32_t gain = ditherGain(40, 255);
+    while (state.keepRunning()) {
+        applyColorLutDithered(lut, leds, wire, residual.ch, NUM_LEDS, gain);
+        bench::doNotOptimize(wire[NUM_LEDS / 2]);
+        bench::clobberMemory();
+    }
+    state.setItemsPerIteration(NUM_LEDS);
+}
+BENCHMARK(BM_ApplyColorLutDithered);
+
+static void BM_UpdateStateFromPacketV1(bench::State &state) {
+    primeState(2, 0);
+    std::vector<uint8_t> buf = makeV1(2, 0);
+    Packet packet;
+    parsePacket(buf.data(), buf.size(), packet);
+    while (state.keepRunning()) {
+        packet.frame_id++;
+        packet.seq = packet.frame_id;
+        hostAdvanceMillis(kPacketMs);
+        updateStateFromPacket(packet, millis());
+        bench::doNotOptimize(targetState);
+    }
+}
+BENCHMARK(BM_UpdateStateFromPacketV1);
+
+static void BM_UpdateStateFromPacketV2Zones16(bench::State &state) {
+    primeState(1, 16);
+    std::vector<uint8_t> buf = makeV2(1, 0, 0, 16);
+    Packet packet;
+    parsePacket(buf.data(), buf.size(), packet);
+    while (state.keepRunning()) {
+        packet.seq++;
+        packet.sender_ms += kPacketMs;
+        hostAdvanceMillis(kPacketMs);
+        updateStateFromPacket(packet, millis());
+        interpolateRenderState(millis());
+        bench::doNotOptimize(renderState);
+    }
+}
+BENCHMARK(BM_UpdateStateFromPacketV2Zones16);
+
+static void runParse(bench::State &state, const std::vector<uint8_t> &buf) {
+    Packet packet;
+    while (state.keepRunning()) {
+        bool ok = parsePacket(buf.data(), buf.size(), packet);
+        bench::doNotOptimize(ok);
+        bench::doNotOptimize(packet);
+    }
+    state.setItemsPerIteration(buf.size());
+}
+
+static void BM_ParseV1Valid(bench::State &state) {
+    runParse(state, makeV1(1, 7));
+}
+BENCHMARK(BM_ParseV1Valid);
+
+static void BM_ParseV1BadChecksum(bench::State &state) {
+    std::vector<uint8_t> buf = makeV1(1, 7);
+    buf[10] ^= 0x5A;
+    runParse(state, buf);
+}
+BENCHMARK(BM_ParseV1BadChecksum);
+
+static void BM_ParseV2Valid(bench::State &state) {
+    runParse(state, makeV2(2, 7, 123456, 0));
+}
+BENCHMARK(BM_ParseV2Valid);
+
+static void BM_ParseV2Zones32(bench::State &state) {
+    runParse(state, makeV2(1, 7, 123456, MAX_ZONES));
+}
+BENCHMARK(BM_ParseV2Zones32);
+
+static void BM_ParseV2BadCrc(bench::State &state) {
+    std::vector<uint8_t> buf = makeV2(1, 7, 123456, MAX_ZONES);
+    buf[20] ^= 0x01;
+    runParse(state, buf);
+}
+BENCHMARK(BM_ParseV2BadCrc);
+
+static void BM_ParseGarbage(bench::State &state) {
+    std::vector<uint8_t> buf(64);
+    for (size_t i = 0; i < buf.size(); ++i) buf[i] = uint8_t(i * 37 + 11);
+    runParse(state, buf);
+}
+BENCHMARK(BM_ParseGarbage);
+
+static void BM_JitterBufferInOrder(bench::State &state) {
+    jitterBufferReset();
+    std::vector<uint8_t> buf = makeV2(2, 0, 0, 0);
+    Packet packet, out;
+    parsePacket(buf.data(), buf.size(), packet);
+    unsigned long playoutMs;
+    while (state.keepRunning()) {
+        packet.seq++;
+        packet.sender_ms += kPacketMs;
+        hostAdvanceMillis(kPacketMs);
+        jitterBufferPush(packet, millis());
+        while (jitterBufferPop(millis() + JITTER_MAX_DELAY_MS, out, playoutMs)) bench::doNotOptimize(out);
+    }
+}
+BENCHMARK(BM_JitterBufferInOrder);
+
+int main(int argc, char **argv) {
+    return bench::runMain(argc, argv);
+}
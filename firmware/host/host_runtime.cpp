@@ -0,0 +1,104 @@
+// host_runtime.cpp
+// Replaces renderer.cpp/FreeRTOS on the host: one static LED buffer, a manual clock and a
+// frame sink in place of the output task.
+#include "config.h"
+#include "host_runtime.h"
+#include "power_meter.h"
+#include "renderer.h"
+
+HostSerial Serial;
+
+static CRGB frameBuffers[3][NUM_LEDS];
+CRGB *leds = frameBuffers[0];
+
+static unsigned long nowMs = 0;
+static uint8_t frameBrightness = 255;
+static HostFrameSink frameSink = nullptr;
+static void *frameSinkCtx = nullptr;
+
+unsigned long millis() {
+    return nowMs;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return 240;
+}
+
+void hostSetMillis(unsigned long ms) {
+    nowMs = ms;
+}
+
+void hostAdvanceMillis(unsigned long ms) {
+    nowMs += ms;
+}
+
+void setFrameBrightness(uint8_t brightness) {
+    frameBrightness = brightness;
+}
+
+uint8_t hostFrameBrightness() {
+    return frameBrightness;
+}
+
+void hostSetFrameSink(HostFrameSink sink, void *ctx) {
+    frameSink = sink;
+    frameSinkCtx = ctx;
+}
+
+void presentFrame() {
+#if ENABLE_SEGMENT_POWER_LIMIT
+    // Same handoff as the device: kernel frames arrive metered, raw frames are measured here.
+    if (!framePower.complete()) framePower.measure(leds);
+#endif
+    if (frameSink) frameSink(leds, frameBrightness, frameSinkCtx);
+#if ENABLE_SEGMENT_POWER_LIMIT
+    framePower.invalidate();
+#endif
+}
+
+// Same staging as the device: chunks land in the fill buffer, PUSH and present swap pointers.
+struct RawFrame {
+    CRGB *pixels;
+    uint32_t begin, end;
+};
+static RawFrame rawFill = {frameBuffers[1], 0, 0};
+static RawFrame rawReady = {frameBuffers[2], 0, 0};
+static bool rawReadyFresh = false;
+
+void writeRawPixels(uint32_t byteOffset, const uint8_t *rgb, size_t len) {
+    const size_t frameBytes = sizeof(CRGB) * NUM_LEDS;
+    if (byteOffset >= frameBytes || len == 0) return;
+    if (len > frameBytes - byteOffset) len = frameBytes - byteOffset;
+    memcpy(reinterpret_cast<uint8_t *>(rawFill.pixels) + byteOffset, rgb, len);
+    const uint32_t end = byteOffset + uint32_t(len);
+    if (rawFill.begin == rawFill.end) {
+        rawFill.begin = byteOffset;
+        rawFill.end = end;
+    } else {
+        if (byteOffset < rawFill.begin) rawFill.begin = byteOffset;
+        if (end > rawFill.end) rawFill.end = end;
+    }
+}
+
+void pushRawPixels() {
+    const RawFrame pushed = rawFill;
+    rawFill = rawReady;
+    rawReady = pushed;
+    rawReadyFresh = true;
+    rawFill.begin = rawFill.end = 0;
+}
+
+void presentRawFrame() {
+    if (!rawReadyFresh) return;
+    rawReadyFresh = false;
+    // The previous back buffer is the last presented frame here (no output task).
+    const uint8_t *shown = reinterpret_cast<const uint8_t *>(leds);
+    uint8_t *dst = reinterpret_cast<uint8_t *>(rawReady.pixels);
+    memcpy(dst, shown, rawReady.begin);
+    memcpy(dst + rawReady.end, shown + rawReady.end, sizeof(CRGB) * NUM_LEDS - rawReady.end);
+    CRGB *frame = rawReady.pixels;
+    rawReady.pixels = leds;
+    leds = frame;
+    setFrameBrightness(BRIGHTNESS_CAP);
+    presentFrame();
+}
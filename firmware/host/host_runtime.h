@@ -0,0 +1,17 @@
+// host_runtime.h
+// Host-side stand-ins for the device runtime (LED buffer, clock, frame brightness)
+#pragma once
+#include <FastLED.h>
+
+extern CRGB *leds;
+
+void hostSetMillis(unsigned long ms);
+void hostAdvanceMillis(unsigned long ms);
+
+// Brightness the last rendered frame reported through setFrameBrightness().
+uint8_t hostFrameBrightness();
+
+// Called from presentFrame() with every finished frame (no dirty-frame skip on the host).
+// framePower holds the frame's power meter sums during the call.
+typedef void (*HostFrameSink)(const CRGB *frame, uint8_t brightness, void *ctx);
+void hostSetFrameSink(HostFrameSink sink, void *ctx);
@@ -0,0 +1,45 @@
+// capture.cpp
+#include "capture.h"
+#include <cstdio>
+#include <cstring>
+
+static const char kMagic[8] = {'A', 'L', 'C', 'A', 'P', '1', 0, 0};
+
+bool readCapture(const char *path, std::vector<CaptureRecord> &records, std::string &error) {
+    FILE *f = std::fopen(path, "rb");
+    if (!f) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+    char magic[8];
+    if (std::fread(magic, 1, sizeof(magic), f) != sizeof(magic) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        std::fclose(f);
+        error = "not an ALCAP1 capture";
+        return false;
+    }
+    records.clear();
+    uint8_t hdr[7];
+    size_t got;
+    while ((got = std::fread(hdr, 1, sizeof(hdr), f)) == sizeof(hdr)) {
+        CaptureRecord rec;
+        rec.tMs = uint32_t(hdr[0]) | (uint32_t(hdr[1]) << 8) | (uint32_t(hdr[2]) << 16) | (uint32_t(hdr[3]) << 24);
+        rec.channel = hdr[4];
+        rec.data.resize(size_t(hdr[5]) | (size_t(hdr[6]) << 8));
+        if (!rec.data.empty() && std::fread(rec.data.data(), 1, rec.data.size(), f) != rec.data.size()) {
+            got = 1; // truncated payload
+            break;
+        }
+        if (!records.empty() && rec.tMs < records.back().tMs) {
+            std::fclose(f);
+            error = "timestamps go backwards";
+            return false;
+        }
+        records.push_back(rec);
+    }
+    std::fclose(f);
+    if (got != 0) {
+        error = "truncated record at end of capture";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+// capture.h
+// Reader for ALCAP1 packet captures (ambient_lighting/capture.py, tools/capture_device.py):
+//   "ALCAP1\0\0" then records of [u32 t_ms][u8 channel][u16 len][len bytes], little-endian.
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum CaptureChannel {
+    CAPTURE_CHANNEL_CONTROL = 0, // UDP_PORT datagrams (v1/v2 packets)
+    CAPTURE_CHANNEL_DDP = 1,     // RAW_STREAM_PORT datagrams
+};
+
+struct CaptureRecord {
+    uint32_t tMs;
+    uint8_t channel;
+    std::vector<uint8_t> data;
+};
+
+// Load a whole capture. On failure returns false with a reason in `error`.
+bool readCapture(const char *path, std::vector<CaptureRecord> &records, std::string &error);
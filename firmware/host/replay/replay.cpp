@@ -0,0 +1,187 @@
+// replay.cpp
+// Feeds an ALCAP1 capture through the firmware control loop (controller.cpp) under a
+// virtual millis() clock and records every presented frame.
+//   replay <capture> [--frames=<bin>] [--csv=<path>] [--tail-ms=<n>] [--quiet]
+// --frames writes [u32 t_ms][u8 brightness][NUM_LEDS x r g b] per frame; --csv writes one
+// summary row per frame. The summary ends with an FNV-1a digest of all frames, so two
+// firmware builds can be compared over the same session.
+#include "config.h"
+#include "capture.h"
+#include "controller.h"
+#include "host_runtime.h"
+#include "modes.h"
+#include "power_meter.h"
+#include "protocol.h"
+#include "renderer.h"
+#include "state.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct ReplayStats {
+    FILE *frames = nullptr;
+    FILE *csv = nullptr;
+    uint64_t digest = 1469598103934665603ULL;
+    uint32_t frameCount = 0;
+    uint32_t packetsOk = 0;
+    uint32_t packetsBad = 0;
+    uint32_t rawFrames = 0;
+    float lastPhase = 0.0f;
+    double phaseStepSum = 0.0;
+    double phaseStepSqSum = 0.0;
+    uint64_t deltaSum = 0;
+    uint32_t deltaMax = 0;
+    uint32_t peakMa = 0;
+    CRGB prev[NUM_LEDS];
+};
+
+static void onFrame(const CRGB *frame, uint8_t brightness, void *ctx) {
+    ReplayStats &st = *static_cast<ReplayStats *>(ctx);
+    const unsigned long nowMs = millis();
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(frame);
+    const size_t frameBytes = sizeof(CRGB) * NUM_LEDS;
+
+    st.digest = (st.digest ^ brightness) * 1099511628211ULL;
+    uint32_t sum[3] = {0, 0, 0};
+    uint32_t delta = 0;
+    for (size_t i = 0; i < frameBytes; ++i) {
+        st.digest = (st.digest ^ bytes[i]) * 1099511628211ULL;
+        sum[i % 3] += bytes[i];
+        if (st.frameCount) delta += uint32_t(std::abs(int(bytes[i]) - int(reinterpret_cast<const uint8_t *>(st.prev)[i])));
+    }
+    memcpy(st.prev, frame, frameBytes);
+
+    // Phase step per frame: its spread is the stutter the jitter buffer is meant to remove.
+    float step = st.frameCount ? renderState.render_phase - st.lastPhase : 0.0f;
+    st.lastPhase = renderState.render_phase;
+    if (st.frameCount) {
+        st.phaseStepSum += step;
+        st.phaseStepSqSum += double(step) * step;
+        st.deltaSum += delta;
+        if (delta > st.deltaMax) st.deltaMax = delta;
+    }
+    st.frameCount++;
+
+    // Power model estimate before any color LUT (unity gain), summed over all segments.
+    static const uint16_t kUnityGain[3] = {256, 256, 256};
+    uint32_t estMa = 0;
+    for (int s = 0; s < SEGMENT_COUNT; ++s) estMa += estimateSegmentMa(framePower.sums(), s, brightness, kUnityGain);
+    if (estMa > st.peakMa) st.peakMa = estMa;
+
+    if (st.frames) {
+        uint8_t hdr[5] = {uint8_t(nowMs), uint8_t(nowMs >> 8), uint8_t(nowMs >> 16), uint8_t(nowMs >> 24), brightness};
+        std::fwrite(hdr, 1, sizeof(hdr), st.frames);
+        std::fwrite(bytes, 1, frameBytes, st.frames);
+    }
+    if (st.csv) {
+        std::fprintf(st.csv, "%lu,%u,%u,%.5f,%.5f,%.1f,%u,%u,%u,%u,%u\n", nowMs, targetState.mode, brightness,
+                     renderState.render_phase, step, renderState.render_motion_energy,
+                     sum[0] / NUM_LEDS, sum[1] / NUM_LEDS, sum[2] / NUM_LEDS, delta, estMa);
+    }
+}
+
+static void deliver(const CaptureRecord &rec, unsigned long nowMs, ReplayStats &st, bool &rawPush) {
+    if (rec.channel == CAPTURE_CHANNEL_CONTROL) {
+        Packet packet;
+        if (parsePacket(rec.data.data(), rec.data.size(), packet)) {
+            st.packetsOk++;
+            controllerOnPacket(packet, nowMs);
+        } else {
+            st.packetsBad++;
+        }
+    } else if (rec.channel == CAPTURE_CHANNEL_DDP) {
+        DdpHeader hdr;
+        if (!parseDdp(rec.data.data(), rec.data.size(), hdr)) {
+            st.packetsBad++;
+            return;
+        }
+        writeRawPixels(hdr.offset, hdr.payload, hdr.length);
+        if (hdr.push) {
+            pushRawPixels();
+            rawPush = true;
+            st.rawFrames++;
+        }
+    }
+}
+
+static int usage(const char *argv0) {
+    std::fprintf(stderr, "usage: %s <capture.alcap> [--frames=<bin>] [--csv=<path>] [--tail-ms=<n>] [--quiet]\n", argv0);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *capturePath = nullptr;
+    const char *framesPath = nullptr;
+    const char *csvPath = nullptr;
+    unsigned long tailMs = 2500; // long enough to see the 1.8 s fallback after the last packet
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--frames=", 9) == 0) framesPath = argv[i] + 9;
+        else if (std::strncmp(argv[i], "--csv=", 6) == 0) csvPath = argv[i] + 6;
+        else if (std::strncmp(argv[i], "--tail-ms=", 10) == 0) tailMs = std::strtoul(argv[i] + 10, nullptr, 10);
+        else if (std::strcmp(argv[i], "--quiet") == 0) quiet = true;
+        else if (argv[i][0] != '-' && !capturePath) capturePath = argv[i];
+        else return usage(argv[0]);
+    }
+    if (!capturePath) return usage(argv[0]);
+
+    std::vector<CaptureRecord> records;
+    std::string error;
+    if (!readCapture(capturePath, records, error)) {
+        std::fprintf(stderr, "%s: %s\n", capturePath, error.c_str());
+        return 1;
+    }
+
+    static ReplayStats st;
+    if (framesPath && !(st.frames = std::fopen(framesPath, "wb"))) {
+        std::fprintf(stderr, "cannot write %s\n", framesPath);
+        return 1;
+    }
+    if (csvPath) {
+        if (!(st.csv = std::fopen(csvPath, "w"))) {
+            std::fprintf(stderr, "cannot write %s\n", csvPath);
+            return 1;
+        }
+        std::fprintf(st.csv, "t_ms,mode,brightness,phase,phase_step,motion_energy,avg_r,avg_g,avg_b,frame_delta,est_ma\n");
+    }
+    hostSetFrameSink(onFrame, &st);
+
+    // Boot as the device does; capture time 0 maps to 1 s after boot.
+    const unsigned long baseMs = 1000;
+    hostSetMillis(0);
+    initModes();
+    initState();
+    controllerInit(0);
+    const unsigned long endMs = baseMs + (records.empty() ? 0 : records.back().tMs) + tailMs;
+
+    size_t next = 0;
+    unsigned long nowMs = 0;
+    unsigned long wakeMs = 0;
+    while (nowMs < endMs) {
+        unsigned long recMs = next < records.size() ? baseMs + records[next].tMs : endMs;
+        nowMs = recMs < wakeMs ? recMs : wakeMs;
+        hostSetMillis(nowMs);
+        bool rawPush = false;
+        while (next < records.size() && baseMs + records[next].tMs <= nowMs) {
+            deliver(records[next++], nowMs, st, rawPush);
+        }
+        if (rawPush) controllerOnRawFrame(nowMs);
+        wakeMs = nowMs + controllerStep(nowMs);
+    }
+
+    if (st.frames) std::fclose(st.frames);
+    if (st.csv) std::fclose(st.csv);
+    if (!quiet) {
+        double n = st.frameCount > 1 ? st.frameCount - 1 : 1;
+        double mean = st.phaseStepSum / n;
+        double var = st.phaseStepSqSum / n - mean * mean;
+        std::printf("records=%zu packets_ok=%u packets_bad=%u raw_frames=%u frames=%u duration_ms=%lu\n",
+                    records.size(), st.packetsOk, st.packetsBad, st.rawFrames, st.frameCount, endMs);
+        std::printf("phase_step_mean=%.5f phase_step_stddev=%.5f frame_delta_mean=%.1f frame_delta_max=%u est_ma_peak=%u\n",
+                    mean, var > 0 ? std::sqrt(var) : 0.0, double(st.deltaSum) / n, st.deltaMax, st.peakMa);
+    }
+    std::printf("digest=%016llx\n", (unsigned long long)st.digest);
+    return st.frameCount > 0 ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+// Arduino.h (host shim)
+// Only what the portable firmware sources use; time is driven by the host harness.
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+unsigned long millis();
+uint32_t getCpuFrequencyMhz();
+
+inline void delay(unsigned long) {}
+
+struct HostSerial {
+    void begin(long) {}
+    template <class T> void print(const T &) {}
+    template <class T> void println(const T &) {}
+    void println() {}
+    template <class... A> void printf(const char *, A...) {}
+};
+extern HostSerial Serial;
@@ -0,0 +1,131 @@
+// FastLED.h (host shim)
+// Bit-exact ports of the FastLED math the effect kernels use (lib8tion C fallbacks), so
+// host timings and output track the device build.
+#pragma once
+#include "Arduino.h"
+
+typedef uint8_t fract8;
+
+struct CRGB {
+    union {
+        struct {
+            uint8_t r, g, b;
+        };
+        uint8_t raw[3];
+    };
+    CRGB() = default;
+    constexpr CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    enum HTMLColorCode { Black = 0x000000 };
+    CRGB(HTMLColorCode code) : r(uint8_t(code >> 16)), g(uint8_t(code >> 8)), b(uint8_t(code)) {}
+    bool operator==(const CRGB &o) const { return r == o.r && g == o.g && b == o.b; }
+    bool operator!=(const CRGB &o) const { return !(*this == o); }
+};
+
+namespace fl {
+template <class T> inline T clamp(T v, T lo, T hi) { return v < lo ? lo : (v > hi ? hi : v); }
+}
+
+inline int16_t sin16(uint16_t theta) {
+    static const uint16_t base[] = {0, 6393, 12539, 18204, 23170, 27245, 30273, 32137};
+    static const uint8_t slope[] = {49, 48, 44, 38, 31, 23, 14, 4};
+    uint16_t offset = (theta & 0x3FFF) >> 3; // 0..2047
+    if (theta & 0x4000) offset = 2047 - offset;
+    uint8_t section = uint8_t(offset / 256);
+    uint16_t mx = uint16_t(slope[section] * (uint8_t(offset) / 2));
+    int16_t y = int16_t(mx + base[section]);
+    if (theta & 0x8000) y = int16_t(-y);
+    return y;
+}
+
+inline uint8_t scale8(uint8_t i, fract8 scale) {
+    return uint8_t((uint16_t(i) * (1 + uint16_t(scale))) >> 8);
+}
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) {
+    unsigned t = unsigned(i) + j;
+    return t > 255 ? 255 : uint8_t(t);
+}
+
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+    uint16_t partial = uint16_t((uint16_t(a) << 8) | b);
+    partial = uint16_t(partial + uint16_t(b) * amountOfB);
+    partial = uint16_t(partial - uint16_t(a) * amountOfB);
+    return uint8_t(partial >> 8);
+}
+
+inline CRGB &nblend(CRGB &existing, const CRGB &overlay, fract8 amountOfOverlay) {
+    if (amountOfOverlay == 0) return existing;
+    if (amountOfOverlay == 255) {
+        existing = overlay;
+        return existing;
+    }
+    existing.r = blend8(existing.r, overlay.r, amountOfOverlay);
+    existing.g = blend8(existing.g, overlay.g, amountOfOverlay);
+    existing.b = blend8(existing.b, overlay.b, amountOfOverlay);
+    return existing;
+}
+
+inline CRGB blend(const CRGB &p1, const CRGB &p2, fract8 amountOfP2) {
+    CRGB nu(p1);
+    nblend(nu, p2, amountOfP2);
+    return nu;
+}
+
+// ---- noise (FastLED noise.cpp, 8-bit 2D C path) ----
+namespace fl_noise {
+static const uint8_t p[] = {
+    151, 160, 137, 91,  90,  15,  131, 13,  201, 95,  96,  53,  194, 233, 7,   225, 140, 36,  103, 30,  69,  142,
+    8,   99,  37,  240, 21,  10,  23,  190, 6,   148, 247, 120, 234, 75,  0,   26,  197, 62,  94,  252, 219, 203,
+    117, 35,  11,  32,  57,  177, 33,  88,  237, 149, 56,  87,  174, 20,  125, 136, 171, 168, 68,  175, 74,  165,
+    71,  134, 139, 48,  27,  166, 77,  146, 158, 231, 83,  111, 229, 122, 60,  211, 133, 230, 220, 105, 92,  41,
+    55,  46,  245, 40,  244, 102, 143, 54,  65,  25,  63,  161, 1,   216, 80,  73,  209, 76,  132, 187, 208, 89,
+    18,  169, 200, 196, 135, 130, 116, 188, 159, 86,  164, 100, 109, 198, 173, 186, 3,   64,  52,  217, 226, 250,
+    124, 123, 5,   202, 38,  147, 118, 126, 255, 82,  85,  212, 207, 206, 59,  227, 47,  16,  58,  17,  182, 189,
+    28,  42,  223, 183, 170, 213, 119, 248, 152, 2,   44,  154, 163, 70,  221, 153, 101, 155, 167, 43,  172, 9,
+    129, 22,  39,  253, 19,  98,  108, 110, 79,  113, 224, 232, 178, 185, 112, 104, 218, 246, 97,  228, 251, 34,
+    242, 193, 238, 210, 144, 12,  191, 179, 162, 241, 81,  51,  145, 235, 249, 14,  239, 107, 49,  192, 214, 31,
+    181, 199, 106, 157, 184, 84,  204, 176, 115, 121, 50,  45,  127, 4,   150, 254, 138, 236, 205, 93,  222, 114,
+    67,  29,  24,  72,  243, 141, 128, 195, 78,  66,  215, 61,  156, 180, 151};
+
+inline uint8_t ease8InOutQuad(uint8_t i) {
+    uint8_t j = (i & 0x80) ? uint8_t(255 - i) : i;
+    uint8_t jj2 = uint8_t(scale8(j, j) << 1);
+    return (i & 0x80) ? uint8_t(255 - jj2) : jj2;
+}
+
+inline int8_t avg7(int8_t i, int8_t j) {
+    return int8_t((i >> 1) + (j >> 1) + (i & 0x1));
+}
+
+inline int8_t lerp7by8(int8_t a, int8_t b, fract8 frac) {
+    if (b > a) return int8_t(a + scale8(uint8_t(b - a), frac));
+    return int8_t(a - scale8(uint8_t(a - b), frac));
+}
+
+inline int8_t grad8(uint8_t hash, int8_t x, int8_t y) {
+    int8_t u = (hash & 4) ? y : x;
+    int8_t v = (hash & 4) ? x : y;
+    if (hash & 1) u = int8_t(-u);
+    if (hash & 2) v = int8_t(-v);
+    return avg7(u, v);
+}
+} // namespace fl_noise
+
+inline int8_t inoise8_raw(uint16_t x, uint16_t y) {
+    using namespace fl_noise;
+    const uint8_t X = uint8_t(x >> 8), Y = uint8_t(y >> 8);
+    const uint8_t A = uint8_t(p[X] + Y), AA = p[A], AB = p[uint8_t(A + 1)];
+    const uint8_t B = uint8_t(p[uint8_t(X + 1)] + Y), BA = p[B], BB = p[uint8_t(B + 1)];
+    const int8_t xx = int8_t((uint8_t(x) >> 1) & 0x7F);
+    const int8_t yy = int8_t((uint8_t(y) >> 1) & 0x7F);
+    const int N = 0x80;
+    const uint8_t u = ease8InOutQuad(uint8_t(x)), v = ease8InOutQuad(uint8_t(y));
+    const int8_t x1 = lerp7by8(grad8(p[AA], xx, yy), grad8(p[BA], int8_t(xx - N), yy), u);
+    const int8_t x2 = lerp7by8(grad8(p[AB], xx, int8_t(yy - N)), grad8(p[BB], int8_t(xx - N), int8_t(yy - N)), u);
+    return lerp7by8(x1, x2, v);
+}
+
+inline uint8_t inoise8(uint16_t x, uint16_t y) {
+    const int8_t n = int8_t(inoise8_raw(x, y) + 64); // -64..64 -> 0..128
+    return qadd8(uint8_t(n), uint8_t(n));
+}
@@ -0,0 +1,69 @@
+"""make_sample_capture.py
+
+Regenerates sample_session.alcap, the small deterministic capture used by the replay smoke
+test: ~12 s of 25 Hz v2 packets with arrival jitter, a few losses and swaps, one corrupt
+datagram, a zone-colored stretch, a v1 tail, then silence (fallback).
+
+Usage:
+  python firmware/host/testdata/make_sample_capture.py
+"""
+
+import binascii
+import os
+import random
+import struct
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.abspath(os.path.join(HERE, '..', '..', '..', 'ambient_lighting')))
+
+from capture import CaptureWriter
+
+
+def v2_packet(mode, rgb, bright, energy, speed, seq, sender_ms, zones=None, direction=224):
+    flags = 0x01 if zones else 0x00
+    body = struct.pack('<BBBB3BBBBBHI', 0xA5, 2, flags, mode, *rgb, bright, energy, speed, direction,
+                       seq & 0xFFFF, sender_ms & 0xFFFFFFFF)
+    if zones:
+        body += bytes([len(zones)]) + b''.join(bytes(z) for z in zones)
+    return body + struct.pack('<H', binascii.crc_hqx(body, 0xFFFF))
+
+
+def v1_packet(mode, rgb, bright, energy, speed, frame_id, direction=32):
+    payload = bytes([mode, *rgb, bright, energy, speed, direction, frame_id & 0xFF])
+    checksum = 0
+    for b in payload:
+        checksum ^= b
+    return bytes([0xAA]) + payload + bytes([checksum, 0x55])
+
+
+def main():
+    rng = random.Random(7)
+    records = []
+    sender_ms = 0
+    for seq in range(300):
+        sender_ms = seq * 40
+        if seq < 200:
+            energy = int(100 + 80 * ((seq % 50) / 50.0))
+            pkt = v2_packet(2, (200, 80, 30), 110, energy, 90, seq, sender_ms)
+        else:
+            zones = [(seq % 256, 40 * z % 256, 255 - 30 * z) for z in range(8)]
+            pkt = v2_packet(1, (120, 60, 200), 85, 60, 40, seq, sender_ms, zones)
+        if rng.random() < 0.02:
+            continue  # lost on the air
+        arrival = sender_ms + 5 + int(rng.expovariate(1 / 6.0))
+        if seq == 120:
+            pkt = pkt[:-1] + bytes([pkt[-1] ^ 0xFF])  # CRC failure
+        records.append((arrival, pkt))
+    t = sender_ms + 40
+    for frame_id in range(25):
+        records.append((t + frame_id * 40 + rng.randint(0, 8), v1_packet(3, (30, 200, 90), 90, 70, 60, frame_id)))
+
+    writer = CaptureWriter(os.path.join(HERE, 'sample_session.alcap'))
+    for arrival, pkt in sorted(records, key=lambda r: r[0]):
+        writer.write(pkt, t_ms=arrival)
+    writer.close()
+
+
+if __name__ == '__main__':
+    main()
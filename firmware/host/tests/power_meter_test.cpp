@@ -0,0 +1,52 @@
+// power_meter_test.cpp
+// Host checks for PowerMeter: per-segment sums, and that pixels past NUM_LEDS are dropped
+// instead of written past the sums.
+#include "config.h"
+#include "power_meter.h"
+#include <cstdio>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+int main() {
+    // Canaries on both sides of the meter catch a write past PowerSums.
+    struct Guarded {
+        uint32_t before[8];
+        PowerMeter meter;
+        uint32_t after[8];
+    };
+    static Guarded g;
+    for (int i = 0; i < 8; ++i) g.before[i] = g.after[i] = 0xA5A5A5A5u;
+
+    const CRGB px(1, 2, 3);
+    g.meter.begin();
+    for (int i = 0; i < NUM_LEDS; ++i) g.meter.add(px);
+    check(g.meter.complete(), "complete after NUM_LEDS pixels");
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+        const uint32_t n = uint32_t(kSegments[s].count);
+        const uint32_t *sum = g.meter.sums().ch[s];
+        check(sum[0] == n && sum[1] == 2 * n && sum[2] == 3 * n, "segment sums");
+    }
+
+    // Overrun: a caller adding twice the strip must leave the sums and the neighbours alone.
+    g.meter.begin();
+    for (int i = 0; i < 2 * NUM_LEDS + 7; ++i) g.meter.add(px);
+    check(g.meter.complete(), "complete after overrun");
+    check(g.meter.sums().ch[SEGMENT_COUNT - 1][0] == uint32_t(kSegments[SEGMENT_COUNT - 1].count),
+          "last segment sum unchanged by overrun");
+    for (int i = 0; i < 8; ++i) check(g.before[i] == 0xA5A5A5A5u && g.after[i] == 0xA5A5A5A5u, "canaries");
+
+    // Adding after invalidate() (no begin()) stays in bounds too.
+    g.meter.invalidate();
+    for (int i = 0; i < 3 * NUM_LEDS; ++i) g.meter.add(px);
+    for (int i = 0; i < 8; ++i) check(g.before[i] == 0xA5A5A5A5u && g.after[i] == 0xA5A5A5A5u, "canaries after invalidate");
+
+    if (failures == 0) std::printf("power_meter_test: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// color_lut.cpp
+// Per-segment gamma/white-balance lookup tables applied in the LED output stage
+#include "config.h"
+#include "color_lut.h"
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <string.h>
+
+static ColorLut activeLuts[SEGMENT_COUNT];
+// Single-slot handover per segment: the uploader fills stagedLuts[s] and sets bit s, the
+// output task copies it over and clears the bit.
+static ColorLut stagedLuts[SEGMENT_COUNT];
+static std::atomic<uint8_t> stagedMask(0);
+static uint16_t activeGainQ8[SEGMENT_COUNT][3];
+
+// Peak out/in ratio from input 16 up: below that the ratio is dominated by rounding and the
+// current involved is negligible.
+static void updateGain(uint8_t segment) {
+    for (int c = 0; c < 3; ++c) {
+        uint32_t peak = 0;
+        for (int v = 16; v < 256; ++v) {
+            peak = std::max(peak, (uint32_t(activeLuts[segment].ch[c][v]) * 256 + v - 1) / v);
+        }
+        activeGainQ8[segment][c] = uint16_t(peak);
+    }
+}
+
+void buildColorLut(ColorLut &lut, float gamma, uint8_t whiteR, uint8_t whiteG, uint8_t whiteB) {
+    const uint8_t white[3] = {whiteR, whiteG, whiteB};
+    for (int v = 0; v < 256; ++v) {
+        const float level = powf(float(v) / 255.0f, gamma);
+        for (int c = 0; c < 3; ++c) {
+            lut.ch[c][v] = uint8_t(float(white[c]) * level + 0.5f);
+        }
+    }
+}
+
+void buildDefaultColorLut(ColorLut &lut) {
+    buildColorLut(lut, COLOR_LUT_GAMMA, COLOR_LUT_WHITE_R, COLOR_LUT_WHITE_G, COLOR_LUT_WHITE_B);
+}
+
+void installColorLut(uint8_t segment, const uint8_t *table) {
+    if (segment >= SEGMENT_COUNT) return;
+    memcpy(activeLuts[segment].ch, table, COLOR_LUT_BYTES);
+    updateGain(segment);
+}
+
+const ColorLut &colorLut(uint8_t segment) {
+    return activeLuts[segment];
+}
+
+const uint16_t *colorLutGainQ8(uint8_t segment) {
+    return activeGainQ8[segment];
+}
+
+void applyColorLut(const ColorLut &lut, const CRGB *src, CRGB *dst, size_t count, uint8_t scale) {
+    const uint8_t *r = lut.ch[0];
+    const uint8_t *g = lut.ch[1];
+    const uint8_t *b = lut.ch[2];
+    if (scale == 255) {
+        for (size_t i = 0; i < count; ++i) {
+            dst[i].r = r[src[i].r];
+            dst[i].g = g[src[i].g];
+            dst[i].b = b[src[i].b];
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        dst[i].r = scale8(r[src[i].r], scale);
+        dst[i].g = scale8(g[src[i].g], scale);
+        dst[i].b = scale8(b[src[i].b], scale);
+    }
+}
+
+bool stageColorLut(uint8_t segment, const uint8_t *table) {
+    if (segment >= SEGMENT_COUNT) return false;
+    const uint8_t bit = uint8_t(1u << segment);
+    if (stagedMask.load(std::memory_order_acquire) & bit) return false;
+    memcpy(stagedLuts[segment].ch, table, COLOR_LUT_BYTES);
+    stagedMask.fetch_or(bit, std::memory_order_release);
+    return true;
+}
+
+void commitStagedColorLuts() {
+    const uint8_t mask = stagedMask.load(std::memory_order_acquire);
+    if (mask == 0) return;
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+        if (mask & (1u << s)) {
+            activeLuts[s] = stagedLuts[s];
+            updateGain(uint8_t(s));
+        }
+    }
+    stagedMask.fetch_and(uint8_t(~mask), std::memory_order_release);
+}
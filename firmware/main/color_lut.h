@@ -0,0 +1,43 @@
+// color_lut.h
+// Per-segment gamma/white-balance lookup tables applied in the LED output stage
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <FastLED.h>
+#include "config.h"
+
+// One table per channel, indexed by the rendered 0..255 value. This is also the upload/NVS
+// layout: 256 R entries, then 256 G, then 256 B.
+#define COLOR_LUT_BYTES (3 * 256)
+
+struct ColorLut {
+    uint8_t ch[3][256];
+};
+
+// out = white * (v / 255) ^ gamma, rounded. Uses powf, so it is meant for boot and resets
+// only; the output stage itself is pure table lookups.
+void buildColorLut(ColorLut &lut, float gamma, uint8_t whiteR, uint8_t whiteG, uint8_t whiteB);
+
+// Built-in table from COLOR_LUT_GAMMA / COLOR_LUT_WHITE_*.
+void buildDefaultColorLut(ColorLut &lut);
+
+// Make `table` (COLOR_LUT_BYTES) the active table for `segment`. Only for setup, before the
+// output task runs; at runtime use stageColorLut().
+void installColorLut(uint8_t segment, const uint8_t *table);
+
+// Active table for `segment` (output task).
+const ColorLut &colorLut(uint8_t segment);
+
+// Largest out/in ratio (inputs >= 16) per channel of the active table for `segment` (Q8, 256 = 1:1), used
+// by the power estimate. Output task.
+const uint16_t *colorLutGainQ8(uint8_t segment);
+
+// Copy `count` pixels from `src` to `dst` through `lut`, then scale8 by `scale` unless 255.
+void applyColorLut(const ColorLut &lut, const CRGB *src, CRGB *dst, size_t count, uint8_t scale = 255);
+
+// Hand a new table for `segment` to the output task (any task). Returns false if the
+// previous table for that segment has not been taken over yet.
+bool stageColorLut(uint8_t segment, const uint8_t *table);
+
+// Adopt staged tables; called by the output task before it applies them to a frame.
+void commitStagedColorLuts();
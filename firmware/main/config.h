@@ -6,15 +6,60 @@
 #define LED_TYPE       WS2812B
 #define COLOR_ORDER    GRB
 #define NUM_LEDS       600
+
+// Cove geometry (geometry.h): LED counts of the straight runs in strip order, with a 90-degree
+// corner between consecutive runs (COVE_CORNER_TURN 1 = left turns, -1 = right). Spatial
+// effects use room position, e.g. "150, 150, 150, 150" for a square room. Default: one
+// straight run.
+#ifndef COVE_RUN_LENGTHS
+#define COVE_RUN_LENGTHS NUM_LEDS
+#endif
+#ifndef COVE_CORNER_TURN
+#define COVE_CORNER_TURN 1
+#endif
 #define BRIGHTNESS_CAP 255
 #define MOTION_SPEED_CAP 255
 #define UDP_PORT       4210
+#define RAW_STREAM_PORT 4048   // DDP raw pixel stream (see protocol.h)
 #define PACKET_SIZE    12
 #define WIFI_SSID      "TP-Link_5ACC"
 #define WIFI_PASS      "986678sv"
 #define SERIAL_BAUD    115200
 #define STATE_SAVE_FILE "/mode.dat"
 
+// Strip segments: each one is its own data pin (and power-injection run). FastLED's ESP32
+// RMT driver transmits all segments in parallel, so show() time scales with the longest
+// segment instead of NUM_LEDS. leds[] stays one logical buffer; segment n covers the
+// SEGMENTn_LEDS LEDs following segment n-1. Define FASTLED_ESP32_I2S 1 here to use
+// FastLED's I2S parallel driver instead of RMT.
+#ifndef SEGMENT_COUNT
+#define SEGMENT_COUNT 1
+#endif
+#ifndef SEGMENT0_PIN
+#define SEGMENT0_PIN LED_PIN
+#endif
+#ifndef SEGMENT1_PIN
+#define SEGMENT1_PIN 18
+#endif
+#ifndef SEGMENT2_PIN
+#define SEGMENT2_PIN 19
+#endif
+#ifndef SEGMENT3_PIN
+#define SEGMENT3_PIN 21
+#endif
+#ifndef SEGMENT0_LEDS
+#define SEGMENT0_LEDS (NUM_LEDS / SEGMENT_COUNT)
+#endif
+#ifndef SEGMENT1_LEDS
+#define SEGMENT1_LEDS (NUM_LEDS / SEGMENT_COUNT)
+#endif
+#ifndef SEGMENT2_LEDS
+#define SEGMENT2_LEDS (NUM_LEDS / SEGMENT_COUNT)
+#endif
+#ifndef SEGMENT3_LEDS
+#define SEGMENT3_LEDS (NUM_LEDS / SEGMENT_COUNT)
+#endif
+
 // Fallback behavior (used when UDP packets stop)
 // Keep these as plain integers (not uint8_t) so they are safe in preprocessor math.
 #ifndef FALLBACK_MODE
@@ -32,6 +77,58 @@
 #ifndef FALLBACK_BRIGHTNESS
 #define FALLBACK_BRIGHTNESS 255
 #endif
+// 1 = fallback shows the color/brightness of the last scene the laptop sent in Modes 1-4
+// (still as FALLBACK_MODE, without motion); FALLBACK_R/G/B/BRIGHTNESS are used until then.
+// 0 = always the fixed fallback color.
+#ifndef FALLBACK_USE_LAST_SCENE
+#define FALLBACK_USE_LAST_SCENE 1
+#endif
+
+// Scene engine (scenes.h): with no packets the strip runs an on-device procedural scene
+// (breathing, noise field, travelling gradient or sunrise) instead of one static color.
+// Scenes are parameter records uploaded with CONTROL_CMD_SCENES and kept in NVS; until one
+// is, the SCENE_DEFAULT_* scene runs (default: the classic breathing fallback in the last
+// good scene's color). Scene frames render every SCENE_FRAME_MS; the laptop taking over
+// again cross-fades over SCENE_HANDOVER_MS.
+#ifndef ENABLE_SCENE_ENGINE
+#define ENABLE_SCENE_ENGINE 1
+#endif
+#ifndef MODE_SCENE
+#define MODE_SCENE 7
+#endif
+#ifndef SCENE_SLOTS
+#define SCENE_SLOTS 4
+#endif
+#ifndef SCENE_FRAME_MS
+#define SCENE_FRAME_MS 40
+#endif
+#ifndef SCENE_HANDOVER_MS
+#define SCENE_HANDOVER_MS 1500
+#endif
+#ifndef SCENE_DEFAULT_EFFECT
+#define SCENE_DEFAULT_EFFECT 0   // SCENE_BREATHE
+#endif
+#ifndef SCENE_DEFAULT_FLAGS
+#define SCENE_DEFAULT_FLAGS 0x01 // SCENE_FLAG_LAST_COLOR
+#endif
+#ifndef SCENE_DEFAULT_SPEED
+#define SCENE_DEFAULT_SPEED 21   // breathing period ~50 s
+#endif
+#ifndef SCENE_DEFAULT_SCALE
+#define SCENE_DEFAULT_SCALE 16
+#endif
+#ifndef SCENE_DEFAULT_MINUTES
+#define SCENE_DEFAULT_MINUTES 30
+#endif
+#ifndef SCENE_DEFAULT_R2
+#define SCENE_DEFAULT_R2 255
+#endif
+#ifndef SCENE_DEFAULT_G2
+#define SCENE_DEFAULT_G2 90
+#endif
+#ifndef SCENE_DEFAULT_B2
+#define SCENE_DEFAULT_B2 20
+#endif
 
 // Safety color clamp
 #define MAX_R 255
@@ -45,6 +142,135 @@
 #define PACKET_BRIGHTNESS_ZERO_IS_NOHINT 1
 #endif
 
+// Protocol v2 packets carry the sender's clock: ease render color/brightness between
+// keyframes over the sender interval instead of stepping at the packet rate.
+#ifndef ENABLE_KEYFRAME_INTERPOLATION
+#define ENABLE_KEYFRAME_INTERPOLATION 1
+#endif
+// Longest keyframe ease; after a keepalive gap the next change still lands this quickly.
+#ifndef KEYFRAME_INTERP_MAX_MS
+#define KEYFRAME_INTERP_MAX_MS 120
+#endif
+
+// Packet cadence. The laptop's adaptive rate sends 25-60 Hz while the scene changes and
+// keepalives up to PACKET_MAX_INTERVAL_MS apart when it is static.
+// No packet for this long: fall back to the last good scene.
+#ifndef PACKET_TIMEOUT_MS
+#define PACKET_TIMEOUT_MS 1800
+#endif
+// Longest sender interval still treated as a continuous stream (no phase reset).
+#ifndef PACKET_MAX_INTERVAL_MS
+#define PACKET_MAX_INTERVAL_MS 1000
+#endif
+// Interval the laptop's motion_speed is scaled to (its 25 Hz base rate): the render phase
+// advances by motion_speed per PACKET_PHASE_DT_MS however often packets arrive.
+// 0 = scale to the measured packet interval (fixed-rate senders only).
+#ifndef PACKET_PHASE_DT_MS
+#define PACKET_PHASE_DT_MS 40
+#endif
+#if PACKET_MAX_INTERVAL_MS >= PACKET_TIMEOUT_MS
+#error "PACKET_MAX_INTERVAL_MS must stay below PACKET_TIMEOUT_MS"
+#endif
+
+// Beat events (v2 beat extension): each new beat starts an envelope rendered every frame,
+// a linear BEAT_ATTACK_MS rise then an exponential decay with time constant BEAT_DECAY_MS,
+// timed from the beat's own timestamp rather than from packet arrival. At full strength it
+// lifts Modes 2/3 by BEAT_MOTION_BOOST motion units and BEAT_BRIGHTNESS_BOOST brightness.
+#ifndef ENABLE_BEAT_ENVELOPE
+#define ENABLE_BEAT_ENVELOPE 1
+#endif
+#ifndef BEAT_ATTACK_MS
+#define BEAT_ATTACK_MS 10
+#endif
+#ifndef BEAT_DECAY_MS
+#define BEAT_DECAY_MS 180
+#endif
+// Beats older than this on arrival (late or re-sent packets) are ignored.
+#ifndef BEAT_MAX_AGE_MS
+#define BEAT_MAX_AGE_MS 150
+#endif
+#ifndef BEAT_MOTION_BOOST
+#define BEAT_MOTION_BOOST 90
+#endif
+#ifndef BEAT_BRIGHTNESS_BOOST
+#define BEAT_BRIGHTNESS_BOOST 40
+#endif
+
+// Jitter buffer between packet receive and state update: reorders by seq, conceals
+// isolated losses, and delays playout by JITTER_DELAY_FACTOR x measured jitter (v2 sender
+// clock), bounded to [JITTER_MIN_DELAY_MS, JITTER_MAX_DELAY_MS].
+#ifndef ENABLE_JITTER_BUFFER
+#define ENABLE_JITTER_BUFFER 1
+#endif
+#ifndef JITTER_SLOTS
+#define JITTER_SLOTS 16
+#endif
+#ifndef JITTER_MIN_DELAY_MS
+#define JITTER_MIN_DELAY_MS 4
+#endif
+#ifndef JITTER_MAX_DELAY_MS
+#define JITTER_MAX_DELAY_MS 80
+#endif
+#ifndef JITTER_DELAY_FACTOR
+#define JITTER_DELAY_FACTOR 3
+#endif
+#ifndef JITTER_CONCEAL_MAX_GAP
+#define JITTER_CONCEAL_MAX_GAP 2
+#endif
+#ifndef JITTER_OFFSET_WINDOW_MS
+#define JITTER_OFFSET_WINDOW_MS 2000
+#endif
+// A sender restart makes seq jump backwards, so every packet looks late. Resync on this many
+// "late" packets in a row (v2: at once when the late packet's sender clock is newer than any
+// buffered one) instead of dropping the stream until the fallback timeout.
+#ifndef JITTER_RESYNC_LATE
+#define JITTER_RESYNC_LATE 4
+#endif
+
+// Stage timing histograms and packet counters, polled with a CONTROL_CMD_STATS datagram
+#ifndef ENABLE_TELEMETRY
+#define ENABLE_TELEMETRY 1
+#endif
+
+// Capture mirror: a CONTROL_CMD_CAPTURE request makes the ESP32 echo every received packet,
+// stamped with its arrival time, to the requester for CAPTURE_LEASE_MS (renewable).
+#ifndef ENABLE_CAPTURE_MIRROR
+#define ENABLE_CAPTURE_MIRROR 1
+#endif
+#ifndef CAPTURE_LEASE_MS
+#define CAPTURE_LEASE_MS 10000
+#endif
+#ifndef CAPTURE_MIRROR_MAX_PAYLOAD
+#define CAPTURE_MIRROR_MAX_PAYLOAD 160
+#endif
+
+// Several units in one room: join this multicast group on UDP_PORT so the laptop sends each
+// frame once (Config.udp_ip = the group). Unicast and broadcast to UDP_PORT keep working.
+// Presentation is aligned by the v2 sync extension (jitter_buffer.h); use the same group on
+// every unit that shares a stream.
+#ifndef ENABLE_UDP_MULTICAST
+#define ENABLE_UDP_MULTICAST 1
+#endif
+#ifndef UDP_MULTICAST_GROUP
+#define UDP_MULTICAST_GROUP 239, 10, 42, 1
+#endif
+
+// Protocol v2 zone payload: up to MAX_ZONES packed RGB colors spread evenly along the strip
+// and blended per LED (zones.cpp).
+#ifndef MAX_ZONES
+#define MAX_ZONES 32
+#endif
+
+// Raw pixel streaming (DDP): the laptop renders whole frames and each datagram is copied once,
+// into a spare frame buffer that becomes the back buffer by pointer swaps (renderer.h).
+// Selected automatically while frames arrive.
+#ifndef ENABLE_RAW_STREAM
+#define ENABLE_RAW_STREAM 1
+#endif
+#ifndef MODE_RAW
+#define MODE_RAW 6
+#endif
+
 // FastLED power limiting. Disable only if you have sufficient power injection.
 #ifndef ENABLE_POWER_LIMIT
 #define ENABLE_POWER_LIMIT 1
@@ -69,6 +295,53 @@
 #endif
 #endif
 
+// Per-segment current limit (power_meter.h) in place of FastLED's whole-strip limiter. The
+// kernels sum each segment's channels while they write the frame; the output task turns that
+// into an estimate and scales just the segments over budget, recovering over POWER_RELEASE_MS.
+// POWER_MA_* are per-LED currents at full scale (FastLED's WS2812 model).
+#ifndef ENABLE_SEGMENT_POWER_LIMIT
+#define ENABLE_SEGMENT_POWER_LIMIT 1
+#endif
+#if DISABLE_POWER_LIMIT
+#undef ENABLE_SEGMENT_POWER_LIMIT
+#define ENABLE_SEGMENT_POWER_LIMIT 0
+#endif
+#ifndef POWER_SEGMENT_LIMIT_MA
+#define POWER_SEGMENT_LIMIT_MA (POWER_LIMIT_MA / SEGMENT_COUNT)
+#endif
+#ifndef POWER_MA_RED
+#define POWER_MA_RED 16
+#endif
+#ifndef POWER_MA_GREEN
+#define POWER_MA_GREEN 11
+#endif
+#ifndef POWER_MA_BLUE
+#define POWER_MA_BLUE 15
+#endif
+#ifndef POWER_MA_IDLE
+#define POWER_MA_IDLE 1
+#endif
+#ifndef POWER_RELEASE_MS
+#define POWER_RELEASE_MS 500
+#endif
+
+// Cross-fade between modes (and across fallback snaps) instead of cutting
+#ifndef ENABLE_MODE_TRANSITIONS
+#define ENABLE_MODE_TRANSITIONS 1
+#endif
+#ifndef MODE_TRANSITION_MS
+#define MODE_TRANSITION_MS 400
+#endif
+
+// Skip FastLED.show() when the frame and its brightness match what is already on the strip.
+// FORCED_REFRESH_MS re-sends anyway so a glitched strip recovers (0 = never force).
+#ifndef ENABLE_DIRTY_FRAME_SKIP
+#define ENABLE_DIRTY_FRAME_SKIP 1
+#endif
+#ifndef FORCED_REFRESH_MS
+#define FORCED_REFRESH_MS 1000
+#endif
+
 // Color calibration (FastLED)
 // Many WS2812B strips look overly green/blue with UncorrectedColor.
 // These defaults add "depth" by warming and balancing channels.
@@ -79,3 +352,128 @@
 #ifndef LED_TEMPERATURE
 #define LED_TEMPERATURE DirectSunlight
 #endif
+
+// Per-segment 3x256 gamma/white-balance LUT applied in the output stage (color_lut.h).
+// Tables uploaded with CONTROL_CMD_COLOR_LUT are kept in NVS; segments without one use the
+// built-in table below. While enabled, FastLED's correction/temperature are left neutral and
+// LED_CORRECTION/LED_TEMPERATURE are unused; the default white point matches TypicalLEDStrip.
+#ifndef ENABLE_COLOR_LUT
+#define ENABLE_COLOR_LUT 1
+#endif
+#ifndef COLOR_LUT_GAMMA
+#define COLOR_LUT_GAMMA 1.0f
+#endif
+#ifndef COLOR_LUT_WHITE_R
+#define COLOR_LUT_WHITE_R 255
+#endif
+#ifndef COLOR_LUT_WHITE_G
+#define COLOR_LUT_WHITE_G 176
+#endif
+#ifndef COLOR_LUT_WHITE_B
+#define COLOR_LUT_WHITE_B 240
+#endif
+
+// Brightness applied per LED in the output stage (dither.h) instead of FastLED's global
+// setBrightness: each channel becomes LUT value x brightness x power scale in 8.8 fixed point,
+// and the fraction is carried per LED into the next transmitted frame (temporal error
+// diffusion), so dim scenes average to in-between levels instead of banding.
+#ifndef ENABLE_TEMPORAL_DITHER
+#define ENABLE_TEMPORAL_DITHER 1
+#endif
+// Re-send a frame that still carries fractions every DITHER_REFRESH_MS, at most
+// DITHER_REFRESH_FRAMES times before the next frame (256 covers a full cycle of any 8-bit
+// fraction). 0 = off: a static or 40 ms scene frame is sent once, as the dirty-frame skip
+// intends, but it holds one rounding of its levels, so very dim fades can step by one level
+// until the next frame. Each re-send is a full show() (RMT time and strip power).
+#ifndef DITHER_REFRESH_FRAMES
+#define DITHER_REFRESH_FRAMES 0
+#endif
+#ifndef DITHER_REFRESH_MS
+#define DITHER_REFRESH_MS 8
+#endif
+
+// Wi-Fi runs in its own task and never blocks boot or rendering. With fast connect, the last
+// association (BSSID, channel, DHCP lease) is kept in NVS and retried first as a static
+// address, skipping the scan and DHCP; reserve the lease on the router so it stays valid.
+// A failed cached attempt falls back to a scan; reconnects back off up to WIFI_RECONNECT_MAX_MS.
+#ifndef ENABLE_WIFI_FAST_CONNECT
+#define ENABLE_WIFI_FAST_CONNECT 1
+#endif
+#ifndef WIFI_FAST_CONNECT_TIMEOUT_MS
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000
+#endif
+#ifndef WIFI_CONNECT_TIMEOUT_MS
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#endif
+#ifndef WIFI_RECONNECT_MIN_MS
+#define WIFI_RECONNECT_MIN_MS 250
+#endif
+#ifndef WIFI_RECONNECT_MAX_MS
+#define WIFI_RECONNECT_MAX_MS 8000
+#endif
+
+// Last good scene kept in NVS (persistence.cpp) and shown again at boot. Changes are
+// coalesced: written once the scene has been unchanged for SCENE_SAVE_STABLE_MS (or has been
+// pending for SCENE_SAVE_MAX_DEFER_MS), never more often than SCENE_SAVE_MIN_INTERVAL_MS,
+// and skipped when identical to what is stored. Flash writes pause both cores briefly, so
+// keep the interval long.
+#ifndef ENABLE_SCENE_PERSISTENCE
+#define ENABLE_SCENE_PERSISTENCE 1
+#endif
+#ifndef SCENE_SAVE_STABLE_MS
+#define SCENE_SAVE_STABLE_MS 5000
+#endif
+#ifndef SCENE_SAVE_MIN_INTERVAL_MS
+#define SCENE_SAVE_MIN_INTERVAL_MS 60000
+#endif
+#ifndef SCENE_SAVE_MAX_DEFER_MS
+#define SCENE_SAVE_MAX_DEFER_MS 600000
+#endif
+
+// FreeRTOS task layout. Wi-Fi/lwIP and the AsyncUDP receive task live on core 0; the
+// render task (state + leds[]) gets core 1.
+#ifndef RENDER_TASK_CORE
+#define RENDER_TASK_CORE 1
+#endif
+#ifndef RENDER_TASK_PRIORITY
+#define RENDER_TASK_PRIORITY 2
+#endif
+// LED output task: transmits the front buffer while the render task fills the back buffer.
+// Kept on the render core so the RMT interrupt is not delayed by Wi-Fi interrupts on core 0.
+#ifndef OUTPUT_TASK_CORE
+#define OUTPUT_TASK_CORE RENDER_TASK_CORE
+#endif
+#ifndef OUTPUT_TASK_PRIORITY
+#define OUTPUT_TASK_PRIORITY (RENDER_TASK_PRIORITY + 1)
+#endif
+#ifndef RENDER_TASK_STACK
+#define RENDER_TASK_STACK 8192
+#endif
+#ifndef OUTPUT_TASK_STACK
+#define OUTPUT_TASK_STACK 4096
+#endif
+// Wi-Fi supervisor (wifi_link.cpp): mostly asleep, on the Wi-Fi core below the lwIP tasks.
+#ifndef WIFI_TASK_CORE
+#define WIFI_TASK_CORE 0
+#endif
+#ifndef WIFI_TASK_PRIORITY
+#define WIFI_TASK_PRIORITY 1
+#endif
+#ifndef WIFI_TASK_STACK
+#define WIFI_TASK_STACK 4096
+#endif
+// Persistence task (persistence.cpp): every NVS write after boot, lowest priority on core 0.
+#ifndef STORAGE_TASK_CORE
+#define STORAGE_TASK_CORE 0
+#endif
+#ifndef STORAGE_TASK_PRIORITY
+#define STORAGE_TASK_PRIORITY 1
+#endif
+#ifndef STORAGE_TASK_STACK
+#define STORAGE_TASK_STACK 4096
+#endif
+
+// Packets buffered between the UDP receive task and the render task (power of two).
+#ifndef PACKET_QUEUE_LEN
+#define PACKET_QUEUE_LEN 16
+#endif
@@ -0,0 +1,207 @@
+// controller.cpp
+// Timing and fallback policy that used to live in main.ino; no I/O beyond the renderer calls,
+// so the same code runs on the device and under a virtual clock on the host.
+#include "config.h"
+#include "controller.h"
+#include "state.h"
+#include "modes.h"
+#include "scenes.h"
+#include "renderer.h"
+#include "jitter_buffer.h"
+#include "telemetry.h"
+#include <Arduino.h>
+
+static unsigned long lastPacketTimeMs = 0;
+static unsigned long lastPacketMs = 0;
+static uint32_t lastPacketSenderMs = 0;
+static uint8_t lastPacketVersion = 0;
+static float lastPacketDtS = 0.040f;
+static bool havePacket = false;
+
+static unsigned long lastRenderMs = 0;
+static unsigned long lastStateMs = 0;
+static const unsigned long renderIntervalMs = 8; // ~125Hz for faster response
+
+static bool fallbackActive = false;
+// Raw stream: while frames keep arriving the kernels stay off, even if control packets
+// (which still update the state) carry another mode.
+static bool haveRawFrame = false;
+static unsigned long lastRawFrameMs = 0;
+
+static bool rawStreamActive(unsigned long nowMs) {
+    return haveRawFrame && long(nowMs - lastRawFrameMs) <= long(PACKET_TIMEOUT_MS);
+}
+// A sync-extension packet was applied: render now instead of at the next frame deadline, so
+// every unit presents it at its playout time.
+static bool presentNow = false;
+
+static void apply_packet(const Packet &packet, unsigned long nowMs);
+static void update_state(float dt);
+
+void controllerInit(unsigned long nowMs) {
+    lastStateMs = nowMs;
+    lastRenderMs = nowMs;
+    lastPacketTimeMs = nowMs;
+    havePacket = false;
+    fallbackActive = false;
+    haveRawFrame = false;
+    lastPacketDtS = 0.040f;
+#if ENABLE_SCENE_ENGINE
+    sceneStart(nowMs);
+#endif
+#if ENABLE_JITTER_BUFFER
+    jitterBufferReset();
+#endif
+}
+
+void controllerOnPacket(const Packet &packet, unsigned long arrivalMs) {
+#if ENABLE_JITTER_BUFFER
+    jitterBufferPush(packet, arrivalMs);
+#else
+    apply_packet(packet, arrivalMs);
+#endif
+}
+
+void controllerOnRawFrame(unsigned long arrivalMs) {
+    // Laptop-rendered frame: staged by the receive task, present it right away.
+    if (targetState.mode != MODE_RAW) {
+        targetState.mode = MODE_RAW;
+        Serial.println("[DDP] Raw pixel stream active");
+    }
+    fallbackActive = false;
+    havePacket = false;
+    lastPacketTimeMs = arrivalMs;
+    haveRawFrame = true;
+    lastRawFrameMs = arrivalMs;
+    presentRawFrame();
+}
+
+static void handle_packets(unsigned long nowMs) {
+#if ENABLE_JITTER_BUFFER
+    Packet packet;
+    unsigned long playoutMs;
+    while (jitterBufferPop(nowMs, packet, playoutMs)) {
+        apply_packet(packet, playoutMs);
+    }
+#endif
+    if (nowMs - lastPacketTimeMs > PACKET_TIMEOUT_MS) {
+        // Fallback to the scene engine (or Mode 4) with the last good scene's color (safe
+        // ambient defaults until one)
+        if (!fallbackActive) {
+        applyFallbackScene();
+        beginTransition();
+        snapRenderStateToTarget(true);
+#if ENABLE_JITTER_BUFFER
+        jitterBufferReset();
+#endif
+#if ENABLE_SCENE_ENGINE
+        sceneStart(nowMs);
+        Serial.println("[FALLBACK] No packet, scene engine");
+#else
+        Serial.println("[FALLBACK] No packet, Mode 4 ambient");
+#endif
+        fallbackActive = true;
+
+        havePacket = false;
+        lastPacketDtS = 0.040f;
+        }
+    }
+}
+
+unsigned long controllerStep(unsigned long nowMs) {
+    handle_packets(nowMs);
+#if ENABLE_SCENE_ENGINE
+    if (commitStagedScenes()) {
+        sceneStart(nowMs);
+        if (targetState.mode == MODE_SCENE) beginTransition();
+    }
+#endif
+
+    float dtState = (nowMs - lastStateMs) / 1000.0f;
+    if (dtState < 0.0f) dtState = 0.0f;
+    update_state(dtState);
+    lastStateMs = nowMs;
+
+    unsigned long intervalMs = renderIntervalMs;
+#if ENABLE_SCENE_ENGINE
+    // Scenes move slowly: drop to SCENE_FRAME_MS once any cross-fade has finished.
+    if (targetState.mode == MODE_SCENE && !transitionActive()) intervalMs = SCENE_FRAME_MS;
+#endif
+    unsigned long sinceRenderMs = nowMs - lastRenderMs;
+    if (sinceRenderMs < intervalMs && !presentNow) {
+        unsigned long sleepMs = intervalMs - sinceRenderMs;
+#if ENABLE_JITTER_BUFFER
+        // Wake for the next playout time rather than up to a frame interval after it.
+        sleepMs = jitterBufferWaitMs(nowMs, sleepMs);
+#endif
+        return sleepMs;
+    }
+    presentNow = false;
+
+    float dtRender = sinceRenderMs / 1000.0f;
+    interpolateRenderState(nowMs);
+#if ENABLE_BEAT_ENVELOPE
+    updateBeatEnvelope(nowMs);
+#endif
+    // Packet-time driven animation
+#if PACKET_PHASE_DT_MS > 0
+    advanceRenderPhase(dtRender, PACKET_PHASE_DT_MS / 1000.0f);
+#else
+    advanceRenderPhase(dtRender, lastPacketDtS);
+#endif
+    renderFrame();
+    lastRenderMs = nowMs;
+    return 0;
+}
+
+static void apply_packet(const Packet &packet, unsigned long nowMs) {
+    if (havePacket) {
+        // v2 packets carry the sender clock; prefer it over the jittery arrival interval.
+        unsigned long dtMs = (packet.version >= 2 && lastPacketVersion >= 2)
+                                 ? (unsigned long)(packet.sender_ms - lastPacketSenderMs)
+                                 : nowMs - lastPacketMs;
+        if (dtMs < 5UL) dtMs = 5UL;
+        if (dtMs > PACKET_MAX_INTERVAL_MS) dtMs = PACKET_MAX_INTERVAL_MS;
+        lastPacketDtS = dtMs / 1000.0f;
+    } else {
+        lastPacketDtS = 0.040f;
+    }
+    lastPacketMs = nowMs;
+    lastPacketSenderMs = packet.sender_ms;
+    lastPacketVersion = packet.version;
+    havePacket = true;
+
+#if ENABLE_SCENE_ENGINE
+    const bool fromScene = targetState.mode == MODE_SCENE;
+#endif
+    uint32_t t0 = telemetryMicros();
+    updateStateFromPacket(packet, nowMs);
+    telemetryRecord(TIMING_STATE, t0);
+    if (rawStreamActive(nowMs)) targetState.mode = MODE_RAW;
+    if (fallbackActive) {
+        // Snap immediately on resume for clean sync.
+        beginTransition();
+        snapRenderStateToTarget(true);
+        fallbackActive = false;
+    }
+#if ENABLE_SCENE_ENGINE
+    // Leaving the scene engine (after a fallback or at boot): the render state is already the
+    // laptop's, only the visible handover is a slow cross-fade.
+    if (fromScene && targetState.mode != MODE_SCENE) beginTransition(SCENE_HANDOVER_MS);
+#endif
+    lastPacketTimeMs = nowMs;
+    if (packet.sync_delay_ms) presentNow = true;
+    static unsigned long lastDbg = 0;
+    if (nowMs - lastDbg > 500) {
+        Serial.printf("[UDP] v%u mode=%u seq=%u rgb=%u,%u,%u bright=%u motionE=%u speed=%u dir=%u pktDt=%.3f jbuf=%lums\n",
+                      packet.version, packet.mode, packet.seq,
+                      packet.r, packet.g, packet.b,
+                      packet.brightness, packet.motion_energy, packet.motion_speed, packet.motion_direction,
+                      lastPacketDtS, jitterBufferDelayMs());
+        lastDbg = nowMs;
+    }
+}
+
+static void update_state(float dt) {
+    smoothState(dt);
+}
@@ -0,0 +1,17 @@
+// controller.h
+// Packet -> state -> frame control loop, shared by the render task and the host replay driver
+#pragma once
+#include "state.h"
+
+void controllerInit(unsigned long nowMs);
+
+// A validated packet taken off the receive queue, with its local arrival time.
+void controllerOnPacket(const Packet &packet, unsigned long arrivalMs);
+
+// A pushed raw (DDP) frame is complete in the back buffer; present it now.
+void controllerOnRawFrame(unsigned long arrivalMs);
+
+// One pass of the render loop at `nowMs`: release due packets, run the fallback check and
+// smoothing, and render when the frame deadline has passed. Returns how long the caller
+// may sleep (0 when a frame was just rendered).
+unsigned long controllerStep(unsigned long nowMs);
@@ -0,0 +1,45 @@
+// dither.cpp
+// Output-stage brightness with temporal error diffusion (see dither.h)
+#include "config.h"
+#include "dither.h"
+
+void initDitherResidual(DitherResidual &residual) {
+    // Golden-ratio steps (159/256) keep neighbouring fractions far apart.
+    for (int i = 0; i < NUM_LEDS; ++i) {
+        for (int c = 0; c < 3; ++c) residual.ch[i][c] = uint8_t((i * 3 + c) * 159);
+    }
+}
+
+// v x gain in 8.8, plus the carried fraction: the integer part goes out, the rest is kept.
+// Peaks at 255 x 65536 >> 8 = 65280, + 255, so the sum stays within 16 bits.
+static inline uint8_t ditherChannel(uint8_t v, uint32_t gain, uint8_t &residual, uint8_t &fraction) {
+    const uint32_t level = (uint32_t(v) * gain) >> 8;
+    fraction |= uint8_t(level);
+    const uint32_t sum = level + residual;
+    residual = uint8_t(sum);
+    return uint8_t(sum >> 8);
+}
+
+bool applyColorLutDithered(const ColorLut &lut, const CRGB *src, CRGB *dst, uint8_t (*residual)[3],
+                           size_t count, uint32_t gain) {
+    const uint8_t *r = lut.ch[0];
+    const uint8_t *g = lut.ch[1];
+    const uint8_t *b = lut.ch[2];
+    uint8_t fraction = 0;
+    for (size_t i = 0; i < count; ++i) {
+        dst[i].r = ditherChannel(r[src[i].r], gain, residual[i][0], fraction);
+        dst[i].g = ditherChannel(g[src[i].g], gain, residual[i][1], fraction);
+        dst[i].b = ditherChannel(b[src[i].b], gain, residual[i][2], fraction);
+    }
+    return fraction != 0;
+}
+
+bool copyDithered(const CRGB *src, CRGB *dst, uint8_t (*residual)[3], size_t count, uint32_t gain) {
+    uint8_t fraction = 0;
+    for (size_t i = 0; i < count; ++i) {
+        dst[i].r = ditherChannel(src[i].r, gain, residual[i][0], fraction);
+        dst[i].g = ditherChannel(src[i].g, gain, residual[i][1], fraction);
+        dst[i].b = ditherChannel(src[i].b, gain, residual[i][2], fraction);
+    }
+    return fraction != 0;
+}
@@ -0,0 +1,33 @@
+// dither.h
+// Output-stage brightness with temporal error diffusion. Each channel is scaled to 8.8 fixed
+// point (LUT value x frame brightness x power scale); the 8-bit part is transmitted and the
+// fraction is kept per LED and added to the next frame, so over a few frames each LED
+// averages to its exact level. One pass replaces the LUT copy and FastLED's brightness scale.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <FastLED.h>
+#include "color_lut.h"
+
+// Per-LED fractions not yet shown, 3 per pixel (r, g, b).
+struct DitherResidual {
+    uint8_t ch[NUM_LEDS][3];
+};
+
+// Spread the starting fractions over the strip (and the channels) so LEDs at the same level
+// step up on different frames instead of flickering in unison.
+void initDitherResidual(DitherResidual &residual);
+
+// Q16 gain (65536 = 1.0) for a frame brightness and a per-segment power scale, 255 = 1.0 each.
+inline uint32_t ditherGain(uint8_t brightness, uint8_t scale) {
+    return uint32_t(brightness + (brightness >> 7)) * uint32_t(scale + (scale >> 7));
+}
+
+// dst = lut(src) x gain, error-diffused through `residual` (its slice for these pixels).
+// Returns true if any channel had a fraction, i.e. the frame must keep being re-sent to show
+// its in-between levels.
+bool applyColorLutDithered(const ColorLut &lut, const CRGB *src, CRGB *dst, uint8_t (*residual)[3],
+                           size_t count, uint32_t gain);
+
+// The same without a LUT.
+bool copyDithered(const CRGB *src, CRGB *dst, uint8_t (*residual)[3], size_t count, uint32_t gain);
@@ -0,0 +1,196 @@
+// effects.h
+// Compile-time configured effect kernels. An effect is a type that names its spatial field,
+// phase direction and modulation range; FieldTable<> bakes the per-LED angles into flash at
+// compile time, and clamps that cannot trigger for the declared range compile away.
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <FastLED.h>
+#include "config.h"
+#include "geometry.h"
+#include "power_meter.h"
+#include "state.h"
+
+namespace fx {
+
+// ---- compile-time index sequences (C++11, logarithmic instantiation depth) ----
+template <size_t... I> struct IndexSeq {
+    typedef IndexSeq<I..., (sizeof...(I) + I)...> Doubled;
+    typedef IndexSeq<I..., (sizeof...(I) + I)..., 2 * sizeof...(I)> DoubledPlusOne;
+};
+
+template <size_t N> struct MakeIndexSeq {
+    typedef typename MakeIndexSeq<N / 2>::Type Half;
+    typedef typename std::conditional<N % 2 != 0, typename Half::DoubledPlusOne, typename Half::Doubled>::type Type;
+};
+template <> struct MakeIndexSeq<0> { typedef IndexSeq<> Type; };
+template <> struct MakeIndexSeq<1> { typedef IndexSeq<0> Type; };
+
+// ---- constexpr angle math (sin16 units: 65536 == 2*pi) ----
+constexpr double kTwoPi = 6.283185307179586;
+
+constexpr double positiveRad(double r) { return r < 0.0 ? r + kTwoPi : r; }
+constexpr double wrapRad(double rad) { return positiveRad(rad - kTwoPi * double(int64_t(rad / kTwoPi))); }
+constexpr uint16_t angle16(double rad) { return uint16_t(uint32_t(wrapRad(rad) * (65536.0 / kTwoPi))); }
+constexpr int centerDistance(int i) { return i < NUM_LEDS / 2 ? NUM_LEDS / 2 - i : i - NUM_LEDS / 2; }
+
+// ---- spatial fields: per-LED angle offsets ----
+// (i - NUM_LEDS/2) / Wavelength radians: a travelling sine along the strip.
+template <int Wavelength> struct LinearField {
+    static const bool kFlat = false;
+    static constexpr uint16_t at(size_t i) { return angle16(double(int(i) - NUM_LEDS / 2) / Wavelength); }
+};
+
+// |i - NUM_LEDS/2| / Scale radians: ripples mirrored around the strip center.
+template <int Scale> struct CenterDistanceField {
+    static const bool kFlat = false;
+    static constexpr uint16_t at(size_t i) { return angle16(double(centerDistance(int(i))) / Scale); }
+};
+
+// Room distance / Scale radians: ripples from the room center (geometry.h), round around
+// corners. On a single straight run this is CenterDistanceField.
+template <int Scale> struct RoomDistanceField {
+    static const bool kFlat = false;
+    static constexpr uint16_t at(size_t i) { return angle16(geo::distance(int(i)) / Scale); }
+};
+
+// Angle around the room center x Turns: a pattern that sweeps around the room once per
+// Turns cycles, whatever the run lengths.
+template <int Turns> struct RoomAngleField {
+    static const bool kFlat = false;
+    static constexpr uint16_t at(size_t i) { return angle16(geo::angle(int(i)) * Turns); }
+};
+
+// Every LED in phase (whole-strip modulation).
+struct FlatField {
+    static const bool kFlat = true;
+};
+
+template <class Field, class Seq> struct FieldTableImpl;
+template <class Field, size_t... I> struct FieldTableImpl<Field, IndexSeq<I...> > {
+    static constexpr uint16_t values[sizeof...(I)] = {Field::at(I)...};
+};
+template <class Field, size_t... I>
+constexpr uint16_t FieldTableImpl<Field, IndexSeq<I...> >::values[sizeof...(I)];
+
+template <class Field> struct FieldTable : FieldTableImpl<Field, typename MakeIndexSeq<NUM_LEDS>::Type> {};
+
+template <class Field, bool Flat = Field::kFlat> struct FieldLookup {
+    static inline uint16_t at(int i) { return FieldTable<Field>::values[i]; }
+};
+template <class Field> struct FieldLookup<Field, true> {
+    static inline uint16_t at(int) { return 0; }
+};
+
+// ---- channel modulation ----
+// c * factorQ8 / 256, clamped to [0, MaxC]. Factors are known to lie in [MinQ8, MaxQ8], so
+// with MAX_* = 255 and factors <= 1.0 no comparison is emitted at all.
+template <int MaxC, int MinQ8, int MaxQ8>
+static inline uint8_t modulate(uint8_t c, int32_t factorQ8) {
+    int32_t v = (int32_t(c) * factorQ8) >> 8;
+    if (MinQ8 < 0 && v < 0) v = 0;
+    if ((MaxQ8 > 256 || MaxC < 255) && v > MaxC) v = MaxC;
+    return uint8_t(v);
+}
+
+static inline uint8_t colorToU8(float c) {
+    return static_cast<uint8_t>(fl::clamp(c, 0.0f, 255.0f));
+}
+
+// ---- write ops: how a kernel stores each finished pixel ----
+struct StoreOp {
+    inline void operator()(CRGB &dst, const CRGB &c) const { dst = c; }
+};
+
+// Cross-fade onto what is already in the buffer: dst += (c - dst) * amount / 256.
+struct BlendOp {
+    uint8_t amount;
+    inline void operator()(CRGB &dst, const CRGB &c) const {
+        dst.r = blend8(dst.r, c.r, amount);
+        dst.g = blend8(dst.g, c.g, amount);
+        dst.b = blend8(dst.b, c.b, amount);
+    }
+};
+
+// Any op, with the final pixel also fed to a power meter (per-segment current estimate).
+template <class Op> struct MeteredOp {
+    Op op;
+    PowerMeter *meter;
+    inline void operator()(CRGB &dst, const CRGB &c) const {
+        op(dst, c);
+        meter->add(dst);
+    }
+};
+
+template <class Op> static inline MeteredOp<Op> metered(Op op, PowerMeter &meter) {
+    MeteredOp<Op> m = {op, &meter};
+    return m;
+}
+
+// ---- sine-modulated effect kernel ----
+// Effect contract:
+//   typedef <field> Field;            spatial angle per LED
+//   static const int kPhaseSign;      +1: sin(field + phase), -1: sin(field - phase)
+//   static const bool kZones;         per-LED zone colors when the sender provides them
+//   static const int kMinFactorQ8, kMaxFactorQ8;   bounds of base +/- depth
+//   static int32_t baseQ8(const RenderState &), depthQ8(const RenderState &);
+// out[i] = color[i] * (base + depth * sin(field[i] +/- phase)), Q8.8, written through `op`.
+// Depth limited so base +/- depth stays inside the effect's declared factor bounds.
+template <class Effect> static inline int32_t boundedDepthQ8(const RenderState &rs, int32_t baseQ8) {
+    return fl::clamp(Effect::depthQ8(rs), int32_t(0),
+                     std::min(int32_t(Effect::kMaxFactorQ8) - baseQ8, baseQ8 - int32_t(Effect::kMinFactorQ8)));
+}
+
+static inline CRGB uniformColor(const RenderState &rs) {
+    return CRGB(colorToU8(rs.render_color.r), colorToU8(rs.render_color.g), colorToU8(rs.render_color.b));
+}
+
+template <class Effect, class Op>
+void renderSineEffect(const RenderState &rs, const CRGB *zones, uint16_t phase, CRGB *out, Op op) {
+    typedef FieldLookup<typename Effect::Field> Field;
+    const int32_t baseQ8 = Effect::baseQ8(rs);
+    const int32_t depthQ8 = boundedDepthQ8<Effect>(rs, baseQ8);
+    const CRGB uniform = uniformColor(rs);
+    if (!Effect::kZones) zones = nullptr;
+    for (int i = 0; i < NUM_LEDS; ++i) {
+        int32_t s = sin16(uint16_t(Field::at(i) + Effect::kPhaseSign * phase));
+        int32_t factor = baseQ8 + ((s * depthQ8) >> 15);
+        const CRGB &c = zones ? zones[i] : uniform;
+        op(out[i], CRGB(modulate<MAX_R, Effect::kMinFactorQ8, Effect::kMaxFactorQ8>(c.r, factor),
+                        modulate<MAX_G, Effect::kMinFactorQ8, Effect::kMaxFactorQ8>(c.g, factor),
+                        modulate<MAX_B, Effect::kMinFactorQ8, Effect::kMaxFactorQ8>(c.b, factor)));
+    }
+}
+
+// Two effects fused per LED: factor = A + (B - A) * mixQ8 / 256 (mixQ8 in 0..256). Both
+// fields are evaluated in the same pass, so the blend costs one color fetch and one store
+// per LED, like a single effect.
+template <class A, class B, class Op>
+void renderBlendedEffect(const RenderState &rs, const CRGB *zones, uint16_t phase, int32_t mixQ8, CRGB *out, Op op) {
+    typedef FieldLookup<typename A::Field> FieldA;
+    typedef FieldLookup<typename B::Field> FieldB;
+    static const int kMinQ8 = A::kMinFactorQ8 < B::kMinFactorQ8 ? A::kMinFactorQ8 : B::kMinFactorQ8;
+    static const int kMaxQ8 = A::kMaxFactorQ8 > B::kMaxFactorQ8 ? A::kMaxFactorQ8 : B::kMaxFactorQ8;
+    const int32_t baseA = A::baseQ8(rs);
+    const int32_t baseB = B::baseQ8(rs);
+    const int32_t depthA = boundedDepthQ8<A>(rs, baseA);
+    const int32_t depthB = boundedDepthQ8<B>(rs, baseB);
+    const int32_t mix = fl::clamp(mixQ8, int32_t(0), int32_t(256));
+    if (mix == 0) return renderSineEffect<A>(rs, zones, phase, out, op);
+    if (mix == 256) return renderSineEffect<B>(rs, zones, phase, out, op);
+    const CRGB uniform = uniformColor(rs);
+    if (!A::kZones && !B::kZones) zones = nullptr;
+    for (int i = 0; i < NUM_LEDS; ++i) {
+        int32_t fa = baseA + ((sin16(uint16_t(FieldA::at(i) + A::kPhaseSign * phase)) * depthA) >> 15);
+        int32_t fb = baseB + ((sin16(uint16_t(FieldB::at(i) + B::kPhaseSign * phase)) * depthB) >> 15);
+        int32_t factor = fa + (((fb - fa) * mix) >> 8);
+        const CRGB &c = zones ? zones[i] : uniform;
+        op(out[i], CRGB(modulate<MAX_R, kMinQ8, kMaxQ8>(c.r, factor),
+                        modulate<MAX_G, kMinQ8, kMaxQ8>(c.g, factor),
+                        modulate<MAX_B, kMinQ8, kMaxQ8>(c.b, factor)));
+    }
+}
+
+} // namespace fx
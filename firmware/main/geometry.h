@@ -0,0 +1,66 @@
+// geometry.h
+// Compile-time cove geometry: where each LED sits in the room, from the straight run
+// lengths in COVE_RUN_LENGTHS. Units are LED pitches; the origin is the center of the
+// runs' bounding box. Everything is constexpr so effect fields can bake distance and angle
+// tables into flash (fx::FieldTable) instead of computing them per frame.
+#pragma once
+#include <cstddef>
+#include "config.h"
+
+namespace geo {
+
+constexpr int kRuns[] = {COVE_RUN_LENGTHS};
+constexpr int kRunCount = int(sizeof(kRuns) / sizeof(kRuns[0]));
+static_assert(kRunCount >= 1 && kRunCount <= 16, "COVE_RUN_LENGTHS: 1 to 16 runs");
+
+constexpr double kPi = 3.141592653589793;
+
+// Heading of run k: a 90-degree COVE_CORNER_TURN at each corner (k quarter turns).
+constexpr int quarter(int k) { return ((k * COVE_CORNER_TURN) % 4 + 4) % 4; }
+constexpr int dirX(int k) { return quarter(k) == 0 ? 1 : quarter(k) == 2 ? -1 : 0; }
+constexpr int dirY(int k) { return quarter(k) == 1 ? 1 : quarter(k) == 3 ? -1 : 0; }
+
+// Corner k: start of run k (k == kRunCount is the end of the last run).
+constexpr int cornerX(int k) { return k == 0 ? 0 : cornerX(k - 1) + dirX(k - 1) * kRuns[k - 1]; }
+constexpr int cornerY(int k) { return k == 0 ? 0 : cornerY(k - 1) + dirY(k - 1) * kRuns[k - 1]; }
+constexpr int runStart(int k) { return k == 0 ? 0 : runStart(k - 1) + kRuns[k - 1]; }
+
+constexpr int minX(int k) { return k < 0 ? 0 : cornerX(k) < minX(k - 1) ? cornerX(k) : minX(k - 1); }
+constexpr int maxX(int k) { return k < 0 ? 0 : cornerX(k) > maxX(k - 1) ? cornerX(k) : maxX(k - 1); }
+constexpr int minY(int k) { return k < 0 ? 0 : cornerY(k) < minY(k - 1) ? cornerY(k) : minY(k - 1); }
+constexpr int maxY(int k) { return k < 0 ? 0 : cornerY(k) > maxY(k - 1) ? cornerY(k) : maxY(k - 1); }
+constexpr double kOriginX = (minX(kRunCount) + maxX(kRunCount)) / 2.0;
+constexpr double kOriginY = (minY(kRunCount) + maxY(kRunCount)) / 2.0;
+
+// Run holding LED i; LEDs past the configured runs continue along the last one.
+constexpr int runOf(int i, int k = 0) {
+    return k + 1 >= kRunCount || i < runStart(k + 1) ? k : runOf(i, k + 1);
+}
+constexpr double ledX(int i) { return cornerX(runOf(i)) + dirX(runOf(i)) * (i - runStart(runOf(i))) - kOriginX; }
+constexpr double ledY(int i) { return cornerY(runOf(i)) + dirY(runOf(i)) * (i - runStart(runOf(i))) - kOriginY; }
+
+// ---- constexpr sqrt / atan2 (C++11 single-expression form) ----
+constexpr double sqrtNewton(double x, double g, int n) { return n == 0 ? g : sqrtNewton(x, 0.5 * (g + x / g), n - 1); }
+constexpr double sqrtC(double x) { return x <= 0.0 ? 0.0 : sqrtNewton(x, x > 1.0 ? x : 1.0, 48); }
+
+// atan(z) for |z| <= 1: two half-angle reductions, then the Taylor series to z^15.
+constexpr double atanSeries(double z, double z2) {
+    return z * (1 - z2 * (1.0 / 3 - z2 * (1.0 / 5 - z2 * (1.0 / 7 - z2 * (1.0 / 9 - z2 * (1.0 / 11 - z2 * (1.0 / 13 - z2 / 15)))))));
+}
+constexpr double halfAngle(double z) { return z / (1.0 + sqrtC(1.0 + z * z)); }
+constexpr double atanUnit(double z) { return 4.0 * atanSeries(halfAngle(halfAngle(z)), halfAngle(halfAngle(z)) * halfAngle(halfAngle(z))); }
+constexpr double absC(double v) { return v < 0.0 ? -v : v; }
+constexpr double atan2C(double y, double x) {
+    return x == 0.0 && y == 0.0 ? 0.0
+         : absC(x) >= absC(y) ? (x > 0.0 ? atanUnit(y / x) : (y >= 0.0 ? kPi : -kPi) + atanUnit(y / x))
+                              : (y > 0.0 ? kPi / 2 : -kPi / 2) - atanUnit(x / y);
+}
+
+// Distance of LED i from the room center, in LED pitches.
+constexpr double distance(int i) {
+    return ledY(i) == 0.0 ? absC(ledX(i)) : ledX(i) == 0.0 ? absC(ledY(i)) : sqrtC(ledX(i) * ledX(i) + ledY(i) * ledY(i));
+}
+// Angle of LED i around the room center, radians in (-pi, pi].
+constexpr double angle(int i) { return atan2C(ledY(i), ledX(i)); }
+
+} // namespace geo
@@ -0,0 +1,224 @@
+// jitter_buffer.cpp
+// Packets are keyed on seq (v2: 16-bit, v1: frame_id). v2 packets are scheduled on the
+// sender clock: playout = sender_ms + clock offset + delay, where the offset is a windowed
+// minimum of (arrival - sender_ms) and the delay follows RFC 3550 interarrival jitter.
+// v1 packets have no sender clock and play out at arrival + delay.
+// A v2 packet with the sync extension replaces the adaptive delay with the sender's fixed
+// one. The offset already includes this unit's own minimum network latency, so units fed the
+// same multicast/broadcast datagram play it out within a millisecond or two of each other.
+#include "config.h"
+#include "jitter_buffer.h"
+#include "telemetry.h"
+
+static_assert((JITTER_SLOTS & (JITTER_SLOTS - 1)) == 0, "JITTER_SLOTS must be a power of two");
+
+struct Slot {
+    bool used;
+    Packet packet;
+    unsigned long arrivalMs;
+};
+
+static Slot slots[JITTER_SLOTS];
+static bool started = false;
+static uint16_t nextSeq = 0;
+static uint16_t seqMask = 0xFF;
+
+static bool haveReleased = false;
+static Packet lastReleased;
+
+// Sender restart detection: "late" packets in a row, newest accepted v2 sender clock
+static uint8_t lateRun = 0;
+static bool haveNewestSender = false;
+static uint32_t newestSenderMs = 0;
+
+// Sender -> local clock mapping (v2)
+static bool haveOffset = false;
+static int32_t offsetCurMin = 0;
+static int32_t offsetPrevMin = 0;
+static unsigned long offsetWindowStartMs = 0;
+
+// Interarrival jitter estimate (ms, Q4) and the playout delay derived from it
+static bool haveTransit = false;
+static int32_t lastTransit = 0;
+static int32_t jitterQ4 = 0;
+static unsigned long playoutDelayMs = JITTER_MIN_DELAY_MS;
+
+static inline uint16_t seqAhead(uint16_t seq, uint16_t base) {
+    return uint16_t(seq - base) & seqMask;
+}
+
+static inline Slot &slotFor(uint16_t seq) {
+    return slots[seq & (JITTER_SLOTS - 1)];
+}
+
+static void restart(uint16_t seq, uint16_t mask) {
+    for (int i = 0; i < JITTER_SLOTS; ++i) slots[i].used = false;
+    seqMask = mask;
+    nextSeq = seq;
+    started = true;
+    haveReleased = false;
+    lateRun = 0;
+    haveNewestSender = false;
+}
+
+static void updateClock(uint32_t senderMs, unsigned long arrivalMs) {
+    int32_t transit = int32_t(uint32_t(arrivalMs) - senderMs);
+    if (!haveOffset) {
+        offsetCurMin = offsetPrevMin = transit;
+        offsetWindowStartMs = arrivalMs;
+        haveOffset = true;
+    } else if (arrivalMs - offsetWindowStartMs > JITTER_OFFSET_WINDOW_MS) {
+        // Two-window minimum follows slow drift between the laptop and ESP32 clocks.
+        offsetPrevMin = offsetCurMin;
+        offsetCurMin = transit;
+        offsetWindowStartMs = arrivalMs;
+    } else if (transit < offsetCurMin) {
+        offsetCurMin = transit;
+    }
+
+    if (haveTransit) {
+        int32_t d = transit - lastTransit;
+        if (d < 0) d = -d;
+        jitterQ4 += ((d << 4) - jitterQ4) >> 4;
+    }
+    lastTransit = transit;
+    haveTransit = true;
+
+    // Target delay covers a few jitter deviations; walk toward it 1 ms per packet so the
+    // playout clock never jumps.
+    unsigned long target = JITTER_MIN_DELAY_MS + JITTER_DELAY_FACTOR * (unsigned long)(jitterQ4 >> 4);
+    if (target > JITTER_MAX_DELAY_MS) target = JITTER_MAX_DELAY_MS;
+    if (target > playoutDelayMs) playoutDelayMs++;
+    else if (target < playoutDelayMs) playoutDelayMs--;
+}
+
+static unsigned long dueMs(const Slot &slot) {
+    if (slot.packet.version >= 2 && haveOffset) {
+        int32_t offset = offsetCurMin < offsetPrevMin ? offsetCurMin : offsetPrevMin;
+        const unsigned long delayMs = slot.packet.sync_delay_ms ? slot.packet.sync_delay_ms : playoutDelayMs;
+        return (unsigned long)(slot.packet.sender_ms + uint32_t(offset) + delayMs);
+    }
+    return slot.arrivalMs + playoutDelayMs;
+}
+
+static inline bool isDue(const Slot &slot, unsigned long nowMs) {
+    return long(nowMs - dueMs(slot)) >= 0;
+}
+
+// Distance (1..JITTER_SLOTS-1) to the first buffered packet after nextSeq, or 0 if none.
+static uint16_t firstBufferedAhead() {
+    for (uint16_t k = 1; k < JITTER_SLOTS; ++k) {
+        uint16_t seq = uint16_t(nextSeq + k) & seqMask;
+        const Slot &slot = slotFor(seq);
+        if (slot.used && slot.packet.seq == seq) return k;
+    }
+    return 0;
+}
+
+static bool laterPacketDue(unsigned long nowMs) {
+    for (uint16_t k = 1; k < JITTER_SLOTS; ++k) {
+        uint16_t seq = uint16_t(nextSeq + k) & seqMask;
+        const Slot &slot = slotFor(seq);
+        if (slot.used && slot.packet.seq == seq && isDue(slot, nowMs)) return true;
+    }
+    return false;
+}
+
+void jitterBufferPush(const Packet &packet, unsigned long arrivalMs) {
+    const uint16_t mask = packet.version >= 2 ? 0xFFFF : 0xFF;
+    if (packet.version >= 2) updateClock(packet.sender_ms, arrivalMs);
+    if (!started || mask != seqMask) restart(packet.seq, mask);
+
+    uint16_t ahead = seqAhead(packet.seq, nextSeq);
+    if (ahead >= JITTER_SLOTS) {
+        if (ahead > seqMask / 2) { // behind the playout point: too late, or a sender restart
+            const bool newerClock = packet.version >= 2 && haveNewestSender &&
+                                    int32_t(packet.sender_ms - newestSenderMs) > 0;
+            if (!newerClock && ++lateRun < JITTER_RESYNC_LATE) {
+                telemetryCount(COUNTER_LATE_DROPPED);
+                return;
+            }
+            if (!newerClock && packet.version >= 2) {
+                // The sender clock went back too: the old offset minimum no longer applies.
+                haveOffset = haveTransit = false;
+                updateClock(packet.sender_ms, arrivalMs);
+            }
+        }
+        // Far ahead (long outage) or restarted sender: start over from this packet.
+        restart(packet.seq, mask);
+    }
+    lateRun = 0;
+    if (packet.version >= 2 && (!haveNewestSender || int32_t(packet.sender_ms - newestSenderMs) > 0)) {
+        newestSenderMs = packet.sender_ms;
+        haveNewestSender = true;
+    }
+
+    Slot &slot = slotFor(packet.seq);
+    if (slot.used && slot.packet.seq == packet.seq) return; // duplicate
+    slot.used = true;
+    slot.packet = packet;
+    slot.arrivalMs = arrivalMs;
+}
+
+bool jitterBufferPop(unsigned long nowMs, Packet &packet, unsigned long &playoutMs) {
+    if (!started) return false;
+
+    Slot &head = slotFor(nextSeq);
+    if (head.used && head.packet.seq == nextSeq) {
+        // Play in order: on time, or early when a later packet is already due.
+        bool due = isDue(head, nowMs);
+        if (!due && !laterPacketDue(nowMs)) return false;
+        packet = head.packet;
+        playoutMs = due ? dueMs(head) : nowMs;
+        head.used = false;
+    } else {
+        // The head is missing; give up on it only when the next buffered packet is due.
+        uint16_t k = firstBufferedAhead();
+        if (k == 0) return false;
+        const Slot &next = slotFor(uint16_t(nextSeq + k) & seqMask);
+        if (!isDue(next, nowMs)) return false;
+        if (k > JITTER_CONCEAL_MAX_GAP || !haveReleased) {
+            // Burst loss: skip ahead and let state.cpp see the gap (phase reset).
+            nextSeq = next.packet.seq;
+            return jitterBufferPop(nowMs, packet, playoutMs);
+        }
+        // Isolated loss: repeat the previous packet in the missing slot so color holds and
+        // the phase keeps advancing instead of resetting.
+        packet = lastReleased;
+        packet.seq = nextSeq;
+        packet.frame_id = uint8_t(nextSeq);
+        packet.sender_ms = lastReleased.sender_ms + (next.packet.sender_ms - lastReleased.sender_ms) / (k + 1);
+        telemetryCount(COUNTER_CONCEALED);
+        playoutMs = nowMs;
+    }
+
+    // Never report a playout time in the future; the caller measures timeouts against it.
+    if (long(playoutMs - nowMs) > 0) playoutMs = nowMs;
+    lastReleased = packet;
+    haveReleased = true;
+    nextSeq = uint16_t(nextSeq + 1) & seqMask;
+    return true;
+}
+
+unsigned long jitterBufferWaitMs(unsigned long nowMs, unsigned long limitMs) {
+    if (!started) return limitMs;
+    const Slot *slot = &slotFor(nextSeq);
+    if (!slot->used || slot->packet.seq != nextSeq) {
+        uint16_t k = firstBufferedAhead();
+        if (k == 0) return limitMs;
+        slot = &slotFor(uint16_t(nextSeq + k) & seqMask);
+    }
+    long waitMs = long(dueMs(*slot) - nowMs);
+    if (waitMs <= 0) return 0;
+    return (unsigned long)waitMs < limitMs ? (unsigned long)waitMs : limitMs;
+}
+
+void jitterBufferReset() {
+    started = false;
+    haveReleased = false;
+    for (int i = 0; i < JITTER_SLOTS; ++i) slots[i].used = false;
+}
+
+unsigned long jitterBufferDelayMs() {
+    return playoutDelayMs;
+}
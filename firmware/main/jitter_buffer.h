@@ -0,0 +1,24 @@
+// jitter_buffer.h
+// Reordering jitter buffer with adaptive playout delay (render task only)
+#pragma once
+#include "state.h"
+
+// Insert a received packet. Late packets (already played out) and duplicates are dropped,
+// unless JITTER_RESYNC_LATE of them in a row (or a v2 one from a newer sender clock) show the
+// sender restarted; the buffer then starts over from that packet.
+void jitterBufferPush(const Packet &packet, unsigned long arrivalMs);
+
+// Release the next packet in sequence order once its playout time has come. `playoutMs`
+// is the (smoothed) local time to treat as the packet's arrival. Isolated losses are
+// concealed by repeating the previous packet under the missing sequence number.
+bool jitterBufferPop(unsigned long nowMs, Packet &packet, unsigned long &playoutMs);
+
+// Time from `nowMs` until the next buffered packet is due, at most `limitMs` (also
+// returned when nothing is buffered). Lets the caller wake right at a playout time.
+unsigned long jitterBufferWaitMs(unsigned long nowMs, unsigned long limitMs);
+
+// Drop everything buffered (stream stopped); clock/jitter estimates are kept.
+void jitterBufferReset();
+
+// Current adaptive playout delay in ms.
+unsigned long jitterBufferDelayMs();
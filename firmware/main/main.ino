@@ -2,111 +2,62 @@
 // Entry point for ESP32 Ambient Cove Lighting
 #include "config.h"
 #include "network.h"
+#include "wifi_link.h"
 #include "state.h"
 #include "renderer.h"
 #include "modes.h"
-#include "storage.h"
+#include "persistence.h"
+#include "packet_queue.h"
+#include "controller.h"
 
-static unsigned long lastPacketTimeMs = 0;
-static unsigned long lastPacketMs = 0;
-static float lastPacketDtS = 0.040f;
-static bool havePacket = false;
+static TaskHandle_t renderTaskHandle = nullptr;
 
-static unsigned long lastRenderMs = 0;
-static unsigned long lastStateMs = 0;
-static const unsigned long renderIntervalMs = 8; // ~125Hz for faster response
-
-static bool fallbackActive = false;
+static void renderTask(void *arg);
 
 void setup() {
     Serial.begin(SERIAL_BAUD);
     Serial.println("[BOOT] ESP32 Ambient Cove Lighting");
-    setupWiFi();
-    setupUDP();
     setupLEDs();
+    const bool restored = persistenceBegin();
     initState();
-    lastStateMs = millis();
-    lastRenderMs = lastStateMs;
-    lastPacketTimeMs = lastStateMs;
-    Serial.println("[INIT] Entering Mode 4");
+    controllerInit(millis());
+#if ENABLE_SCENE_ENGINE
+    Serial.println(restored ? "[INIT] Entering scene engine (last scene)" : "[INIT] Entering scene engine");
+#else
+    Serial.println(restored ? "[INIT] Entering Mode 4 (last scene)" : "[INIT] Entering Mode 4");
+#endif
+
+    // Render the fallback straight away; Wi-Fi associates in the background.
+    xTaskCreatePinnedToCore(renderTask, "render", RENDER_TASK_STACK, nullptr,
+                            RENDER_TASK_PRIORITY, &renderTaskHandle, RENDER_TASK_CORE);
+    setupWiFi();
+    // Packets wake the render task directly; there is no polling loop. The sockets are bound
+    // to any address, so they keep working across reconnects.
+    setupUDP(renderTaskHandle);
 }
 
 void loop() {
-    unsigned long nowMs = millis();
-    handle_udp();
-
-    float dtState = (nowMs - lastStateMs) / 1000.0f;
-    if (dtState < 0.0f) dtState = 0.0f;
-    update_state(dtState);
-    lastStateMs = nowMs;
-
-    if (nowMs - lastRenderMs >= renderIntervalMs) {
-        float dtRender = (nowMs - lastRenderMs) / 1000.0f;
-        if (dtRender < 0.0f) dtRender = 0.0f;
-        // Packet-time driven animation
-        advanceRenderPhase(dtRender, lastPacketDtS);
-        renderFrame();
-        lastRenderMs = nowMs;
-    }
+    // All work runs in the pinned tasks started by setup().
+    vTaskDelete(nullptr);
 }
 
-void handle_udp() {
-    Packet packet;
-    if (receivePacket(packet)) {
-        unsigned long nowMs = millis();
-
-        if (havePacket) {
-            unsigned long dtMs = nowMs - lastPacketMs;
-            if (dtMs < 5UL) dtMs = 5UL;
-            if (dtMs > 120UL) dtMs = 120UL;
-            lastPacketDtS = dtMs / 1000.0f;
-        } else {
-            lastPacketDtS = 0.040f;
-        }
-        lastPacketMs = nowMs;
-        havePacket = true;
-
-        updateStateFromPacket(packet, nowMs);
-        if (fallbackActive) {
-            // Snap immediately on resume for clean sync.
-            snapRenderStateToTarget(true);
-            fallbackActive = false;
+static void renderTask(void * /*arg*/) {
+    for (;;) {
+        Packet packet;
+        unsigned long arrivalMs;
+        while (popPacket(packet, arrivalMs)) {
+            controllerOnPacket(packet, arrivalMs);
         }
-        lastPacketTimeMs = nowMs;
-        static unsigned long lastDbg = 0;
-        if (nowMs - lastDbg > 500) {
-            Serial.printf("[UDP] mode=%u fid=%u rgb=%u,%u,%u bright=%u motionE=%u speed=%u dir=%u pktDt=%.3f\n",
-                          packet.mode, packet.frame_id,
-                          packet.r, packet.g, packet.b,
-                          packet.brightness, packet.motion_energy, packet.motion_speed, packet.motion_direction,
-                          lastPacketDtS);
-            lastDbg = nowMs;
+        if (takeRawFrame(arrivalMs)) {
+            controllerOnRawFrame(arrivalMs);
         }
-    } else if (millis() - lastPacketTimeMs > 1800) {
-        // Fallback to Mode 4 with safe ambient defaults
-        if (!fallbackActive) {
-        targetState.mode = FALLBACK_MODE;
-        targetState.r = static_cast<uint8_t>(FALLBACK_R);
-        targetState.g = static_cast<uint8_t>(FALLBACK_G);
-        targetState.b = static_cast<uint8_t>(FALLBACK_B);
-        targetState.brightness = static_cast<uint8_t>(FALLBACK_BRIGHTNESS);
-#if FORCE_MAX_BRIGHTNESS
-        targetState.brightness = 255;
-#endif
-        targetState.motion_energy = 0;
-        targetState.motion_speed = 0;
-        targetState.motion_direction = 128;
-
-        snapRenderStateToTarget(true);
-        Serial.println("[FALLBACK] No packet, Mode 4 ambient");
-        fallbackActive = true;
-
-        havePacket = false;
-        lastPacketDtS = 0.040f;
+        // Read the clock after draining so no arrival time is ahead of it.
+        const unsigned long nowMs = millis();
+        unsigned long sleepMs = controllerStep(nowMs);
+        persistenceNoteScene(nowMs);
+        if (sleepMs > 0) {
+            // Sleep until the next frame deadline or until a packet arrives, whichever is first.
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleepMs));
         }
     }
 }
-
-void update_state(float dt) {
-    smoothState(dt);
-}
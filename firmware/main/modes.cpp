@@ -3,64 +3,217 @@
 #include "config.h"
 #include <algorithm>
 #include "state.h"
+#include "renderer.h"
+#include "zones.h"
+#include "telemetry.h"
+#include "effects.h"
+#include "scenes.h"
 #include <FastLED.h>
-extern CRGB leds[NUM_LEDS];
-
-void renderMode1() {
-    // Gentle sine modulation, large wavelength
-    float phase = renderState.render_phase;
-    for (int i = 0; i < NUM_LEDS; ++i) {
-        float x = (i - NUM_LEDS/2) / 80.0f;
-        float mod = 0.18f * sinf(x + phase);
-        leds[i] = CRGB(
-            fl::clamp(renderState.render_color.r * (1.0f + mod), 0.0f, float(MAX_R)),
-            fl::clamp(renderState.render_color.g * (1.0f + mod), 0.0f, float(MAX_G)),
-            fl::clamp(renderState.render_color.b * (1.0f + mod), 0.0f, float(MAX_B))
-        );
-    }
-    FastLED.setBrightness(renderState.render_brightness);
+extern CRGB *leds;
+
+static const float kTwoPi = 6.28318530718f;
+static const float kRadToAngle16 = 65536.0f / kTwoPi;
+
+static inline uint16_t radToAngle16(float rad) {
+    // Wrap first so a long-running accumulated phase keeps its precision.
+    float wrapped = fmodf(rad, kTwoPi);
+    if (wrapped < 0.0f) wrapped += kTwoPi;
+    return static_cast<uint16_t>(static_cast<uint32_t>(wrapped * kRadToAngle16));
 }
 
-void renderMode2() {
-    // Center-origin ripples, directional drift
-    float phase = renderState.render_phase;
-    for (int i = 0; i < NUM_LEDS; ++i) {
-        float dist = abs(i - NUM_LEDS/2) / 30.0f;
-        float m = fl::clamp(renderState.render_motion_energy / 180.0f, 0.0f, 1.0f);
-        float amp = 0.15f + 0.50f * m;
-        float ripple = sinf(dist - phase) * amp;
-        float base = 0.85f;
-        leds[i] = CRGB(
-            fl::clamp(renderState.render_color.r * (base + ripple), 0.0f, float(MAX_R)),
-            fl::clamp(renderState.render_color.g * (base + ripple), 0.0f, float(MAX_G)),
-            fl::clamp(renderState.render_color.b * (base + ripple), 0.0f, float(MAX_B))
-        );
-    }
-    FastLED.setBrightness(renderState.render_brightness);
+// Audio modes: the beat envelope (state.h) adds motion and brightness on top of the packet's.
+static inline float beatMotion(const RenderState &rs) {
+    return rs.render_motion_energy + rs.render_beat * BEAT_MOTION_BOOST;
 }
 
-void renderMode3() {
-    // Hybrid: Mode 2 motion, Mode 1 color
-    renderMode2();
+static inline uint8_t beatBrightness(const RenderState &rs) {
+    return uint8_t(fl::clamp(rs.render_brightness + rs.render_beat * BEAT_BRIGHTNESS_BOOST, 0.0f, float(BRIGHTNESS_CAP)));
 }
-void renderMode4() {
-    static float t = 0;
-    t += 0.001f;
-    float breath = 0.95f + 0.05f * sinf(t);
-    for (int i = 0; i < NUM_LEDS; ++i) {
-        leds[i] = CRGB(
-            fl::clamp(renderState.render_color.r * breath, 0.0f, float(MAX_R)),
-            fl::clamp(renderState.render_color.g * breath, 0.0f, float(MAX_G)),
-            fl::clamp(renderState.render_color.b * breath, 0.0f, float(MAX_B))
-        );
+
+// Mode 1: gentle sine modulation, large wavelength: color * (1 + 0.18 * sin(x + phase))
+struct Mode1Effect {
+    typedef fx::LinearField<80> Field;
+    static const int kPhaseSign = 1;
+    static const bool kZones = true;
+    static const int kMinFactorQ8 = 256 - 46;
+    static const int kMaxFactorQ8 = 256 + 46;
+    static int32_t baseQ8(const RenderState &) { return 256; }
+    static int32_t depthQ8(const RenderState &) { return 46; } // 0.18 * 256
+};
+
+// Mode 2: ripples from the room center, directional drift: color * (0.85 + amp * sin(dist - phase)),
+// amp = 0.15 + 0.50 * motion (plus beats); dist follows the cove geometry (COVE_RUN_LENGTHS)
+struct Mode2Effect {
+    typedef fx::RoomDistanceField<30> Field;
+    static const int kPhaseSign = -1;
+    static const bool kZones = true;
+    static const int kMinFactorQ8 = 218 - 166;
+    static const int kMaxFactorQ8 = 218 + 166;
+    static int32_t baseQ8(const RenderState &) { return 218; } // 0.85 * 256
+    static int32_t depthQ8(const RenderState &rs) {
+        float m = fl::clamp(beatMotion(rs) / 180.0f, 0.0f, 1.0f);
+        return int32_t((0.15f + 0.50f * m) * 256.0f);
     }
-    FastLED.setBrightness(renderState.render_brightness);
+};
+
+// Mode 4: whole-strip ultra-slow breathing: color * (0.95 + 0.05 * sin(t)). The factor never
+// exceeds 1.0, so with MAX_* = 255 the kernel has no clamps.
+struct Mode4Effect {
+    typedef fx::FlatField Field;
+    static const int kPhaseSign = 1;
+    static const bool kZones = false;
+    static const int kMinFactorQ8 = 243 - 13;
+    static const int kMaxFactorQ8 = 256;
+    static int32_t baseQ8(const RenderState &) { return 243; }
+    static int32_t depthQ8(const RenderState &) { return 13; }
+};
+
+void initModes() {
+    // Spatial tables are generated at compile time (fx::FieldTable); nothing to build.
+}
+
+// Kernels render `rs` into leds through `op` and return the frame brightness.
+template <class Op> static uint8_t mode1Kernel(const RenderState &rs, Op op) {
+    fx::renderSineEffect<Mode1Effect>(rs, expandZoneColors(rs), radToAngle16(rs.render_phase), leds, op);
+    return rs.render_brightness;
 }
 
-void renderMode5() {
+template <class Op> static uint8_t mode2Kernel(const RenderState &rs, Op op) {
+    fx::renderSineEffect<Mode2Effect>(rs, expandZoneColors(rs), radToAngle16(rs.render_phase), leds, op);
+    return beatBrightness(rs);
+}
+
+template <class Op> static uint8_t mode3Kernel(const RenderState &rs, Op op) {
+    // Hybrid: screen color with the Mode 1 sine when calm, morphing into Mode 2 ripples as
+    // audio motion (and beats) rise. Fused into a single pass over the strip.
+    const float m = fl::clamp(beatMotion(rs) / 180.0f, 0.0f, 1.0f);
+    fx::renderBlendedEffect<Mode1Effect, Mode2Effect>(rs, expandZoneColors(rs), radToAngle16(rs.render_phase),
+                                                      int32_t(m * 256.0f), leds, op);
+    return beatBrightness(rs);
+}
+
+// One breath per 2*pi / (0.001 rad per 8 ms frame). The phase comes from the clock, not from
+// a per-call counter, so a cross-fade rendering Mode 4 twice per frame keeps the same speed.
+static const uint32_t kMode4BreathPeriodMs = 50265;
+
+template <class Op> static uint8_t mode4Kernel(const RenderState &rs, Op op) {
+    const uint32_t t = uint32_t(millis() % kMode4BreathPeriodMs);
+    const uint16_t angle = uint16_t((uint64_t(t) << 16) / kMode4BreathPeriodMs);
+    fx::renderSineEffect<Mode4Effect>(rs, nullptr, angle, leds, op);
+    return rs.render_brightness;
+}
+
+template <class Op> static uint8_t mode5Kernel(const RenderState &, Op op) {
     // OFF
-    for (int i = 0; i < NUM_LEDS; ++i) leds[i] = CRGB::Black;
-    FastLED.setBrightness(0);
+    for (int i = 0; i < NUM_LEDS; ++i) op(leds[i], CRGB(CRGB::Black));
+    return 0;
 }
 
+// Scene engine (no laptop): procedural scene from its own record, not the render state.
+template <class Op> static uint8_t sceneKernel(const RenderState &, Op op) {
+    return renderScene(millis(), leds, op);
+}
 
+template <class Op> static uint8_t renderModeKernel(uint8_t mode, const RenderState &rs, Op op) {
+    switch (mode) {
+        case 1: return mode1Kernel(rs, op);
+        case 2: return mode2Kernel(rs, op);
+        case 3: return mode3Kernel(rs, op);
+        case 5: return mode5Kernel(rs, op);
+#if ENABLE_SCENE_ENGINE
+        case MODE_SCENE: return sceneKernel(rs, op);
+#endif
+        case 4:
+        default: return mode4Kernel(rs, op);
+    }
+}
+
+// The pass that writes the final pixels also sums them per segment for the power limiter.
+template <class Op> static uint8_t renderMeteredKernel(uint8_t mode, const RenderState &rs, Op op) {
+#if ENABLE_SEGMENT_POWER_LIMIT
+    framePower.begin();
+    return renderModeKernel(mode, rs, fx::metered(op, framePower));
+#else
+    return renderModeKernel(mode, rs, op);
+#endif
+}
+
+void renderMode1() { setFrameBrightness(mode1Kernel(renderState, fx::StoreOp())); }
+void renderMode2() { setFrameBrightness(mode2Kernel(renderState, fx::StoreOp())); }
+void renderMode3() { setFrameBrightness(mode3Kernel(renderState, fx::StoreOp())); }
+void renderMode4() { setFrameBrightness(mode4Kernel(renderState, fx::StoreOp())); }
+void renderMode5() { setFrameBrightness(mode5Kernel(renderState, fx::StoreOp())); }
+
+// Mode transitions: the outgoing look is the last rendered RenderState and mode. During a
+// fade it is rendered first, then the incoming mode is blended over it in place, so no
+// scratch frame is needed.
+static RenderState lastRendered;
+static uint8_t lastRenderedMode = 0; // 0 = nothing rendered yet
+static uint8_t lastBrightness = 0;
+static bool transitionRequested = false;
+static unsigned long requestedFadeMs = MODE_TRANSITION_MS;
+
+static bool fadeActive = false;
+static RenderState fadeFrom;
+static uint8_t fadeFromMode = 0;
+static uint8_t fadeFromBrightness = 0;
+static unsigned long fadeStartMs = 0;
+static unsigned long fadeDurationMs = MODE_TRANSITION_MS;
+
+void beginTransition(unsigned long durationMs) {
+    transitionRequested = true;
+    requestedFadeMs = durationMs;
+}
+
+bool transitionActive() {
+    return fadeActive || transitionRequested;
+}
+
+void renderFrame() {
+    const uint8_t mode = targetState.mode;
+    if (mode == MODE_RAW) {
+        // Frames are presented as they arrive (presentRawFrame); nothing to fade from afterwards.
+        lastRenderedMode = MODE_RAW;
+        transitionRequested = false;
+        fadeActive = false;
+        return;
+    }
+    uint32_t t0 = telemetryMicros();
+    const unsigned long nowMs = millis();
+
+#if ENABLE_MODE_TRANSITIONS
+    const unsigned long durationMs = transitionRequested ? requestedFadeMs : MODE_TRANSITION_MS;
+    if ((mode != lastRenderedMode || transitionRequested) && lastRenderedMode != 0 &&
+        lastRenderedMode != MODE_RAW && durationMs > 0) {
+        fadeFrom = lastRendered;
+        fadeFromMode = lastRenderedMode;
+        fadeFromBrightness = lastBrightness;
+        fadeStartMs = nowMs;
+        fadeDurationMs = durationMs;
+        fadeActive = true;
+    }
+#endif
+    transitionRequested = false;
+    requestedFadeMs = MODE_TRANSITION_MS;
+
+    uint8_t brightness;
+    unsigned long fadeMs = nowMs - fadeStartMs;
+    if (fadeActive && fadeMs < fadeDurationMs) {
+        const uint8_t amount = uint8_t(fadeMs * 255UL / fadeDurationMs);
+        renderModeKernel(fadeFromMode, fadeFrom, fx::StoreOp());
+        fx::BlendOp blendOp = {amount};
+        uint8_t to = renderMeteredKernel(mode, renderState, blendOp);
+        brightness = blend8(fadeFromBrightness, to, amount);
+    } else {
+        fadeActive = false;
+        brightness = renderMeteredKernel(mode, renderState, fx::StoreOp());
+    }
+    setFrameBrightness(brightness);
+    lastRendered = renderState;
+    lastRenderedMode = mode;
+    lastBrightness = brightness;
+
+    telemetryRecord(TIMING_KERNEL, t0);
+    telemetryCount(COUNTER_FRAMES_RENDERED);
+    presentFrame();
+}
@@ -1,8 +1,21 @@
 // modes.h
 #pragma once
+#include "config.h"
 
+void initModes();
 void renderMode1();
 void renderMode2();
 void renderMode3();
 void renderMode4();
 void renderMode5();
+
+// Run the kernel for targetState.mode into the back buffer and present it (no-op in MODE_RAW).
+// A mode change cross-fades from the last rendered frame over MODE_TRANSITION_MS.
+void renderFrame();
+
+// Cross-fade the next frame from the current look over `durationMs`, even if the mode stays
+// the same (call before snapping the render state, e.g. on fallback entry/resume).
+void beginTransition(unsigned long durationMs = MODE_TRANSITION_MS);
+
+// A cross-fade is running or requested (render at the full frame rate until it ends).
+bool transitionActive();
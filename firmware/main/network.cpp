@@ -1,56 +1,232 @@
 // network.cpp
-// Handles UDP packet reception and validation
-#include <WiFi.h>
-#include <WiFiUdp.h>
+// Event-driven UDP packet reception/validation and control datagrams
+#include <AsyncUDP.h>
 #include "config.h"
 #include "state.h"
+#include "network.h"
+#include "packet_queue.h"
+#include "protocol.h"
+#include "renderer.h"
+#include "persistence.h"
+#include "telemetry.h"
+#include "color_lut.h"
+#include "scenes.h"
+#if ENABLE_UDP_MULTICAST
+#include "lwip/igmp.h"
+#include "lwip/priv/tcpip_priv.h"
+#endif
+#include <atomic>
+#include <string.h>
 
-WiFiUDP udp;
-
-void setupWiFi() {
-    Serial.println("[WiFi] Connecting...");
-    WiFi.mode(WIFI_STA);
-    // Disable modem sleep for more reliable UDP receive
-    WiFi.setSleep(false);
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(200);
-        Serial.print(".");
+// AsyncUDP delivers datagrams from its own lwIP-fed task, which makes it the single
+// producer of the packet queue.
+AsyncUDP udp;
+static TaskHandle_t packetConsumer = nullptr;
+
+#if ENABLE_CAPTURE_MIRROR
+// Receive task only. The lease lapses on its own so a vanished laptop is not flooded.
+static IPAddress captureIp;
+static uint16_t capturePort = 0;
+static unsigned long captureUntilMs = 0;
+#endif
+
+#if ENABLE_UDP_MULTICAST
+// The group is joined with IGMP on the socket setupUDP() bound to any address, so one
+// socket takes unicast, broadcast and group traffic and a rejoin never rebinds it under
+// the receive task. Joined from setupUDP() or, failing that, the Wi-Fi task.
+static std::atomic<bool> multicastJoined(false);
+
+struct IgmpJoinCall {
+    struct tcpip_api_call_data base; // first member: lwIP hands this pointer back
+    ip4_addr_t group;
+    err_t err;
+};
+
+// Runs on the lwIP thread, which owns the IGMP group lists.
+static err_t igmpJoin(struct tcpip_api_call_data *data) {
+    IgmpJoinCall *call = reinterpret_cast<IgmpJoinCall *>(data);
+    call->err = igmp_joingroup(IP4_ADDR_ANY4, &call->group);
+    return call->err;
+}
+
+static bool joinMulticast() {
+    const IPAddress group(UDP_MULTICAST_GROUP);
+    IgmpJoinCall call;
+    call.group.addr = static_cast<uint32_t>(group);
+    call.err = ERR_VAL;
+    tcpip_api_call(igmpJoin, &call.base);
+    const bool joined = call.err == ERR_OK;
+    multicastJoined.store(joined);
+    if (joined) Serial.printf("[UDP] Joined multicast %s\n", group.toString().c_str());
+    return joined;
+}
+#endif
+
+#if ENABLE_RAW_STREAM
+AsyncUDP rawUdp;
+static std::atomic<uint32_t> rawPushes(0);
+static std::atomic<unsigned long> rawPushMs(0);
+static uint32_t rawPushesSeen = 0; // render task only
+#endif
+
+#if ENABLE_COLOR_LUT
+// The new table reaches the strip with the next transmitted frame (output task).
+static uint8_t handleColorLut(const uint8_t *req, size_t len) {
+    const bool useDefault = (req[2] & CONTROL_LUT_DEFAULT) != 0;
+    const size_t expected = COLOR_LUT_REQUEST_HEADER + (useDefault ? 0 : COLOR_LUT_BYTES) + 2;
+    if (len != expected || req[3] >= SEGMENT_COUNT) return CONTROL_LUT_BAD;
+    if (crc16(req, len - 2) != uint16_t(req[len - 2] | (req[len - 1] << 8))) return CONTROL_LUT_BAD;
+    const uint8_t segment = req[3];
+    const uint8_t *table = req + COLOR_LUT_REQUEST_HEADER;
+    static ColorLut builtIn; // receive task only; kept off its stack
+    if (useDefault) {
+        buildDefaultColorLut(builtIn);
+        table = &builtIn.ch[0][0];
+    }
+    if (!stageColorLut(segment, table)) return CONTROL_LUT_BUSY;
+    if (req[2] & CONTROL_LUT_PERSIST) persistColorLut(segment, useDefault ? nullptr : table);
+    return CONTROL_LUT_OK;
+}
+#endif
+
+#if ENABLE_SCENE_ENGINE
+// The render task takes the records over on its next step (commitStagedScenes()).
+static uint8_t handleScenes(const uint8_t *req, size_t len) {
+    if (len < SCENES_REQUEST_HEADER + 2 || req[4] > SCENE_SLOTS) return SCENE_STAGE_BAD;
+    if (len != SCENES_REQUEST_HEADER + size_t(req[4]) * SCENE_RECORD_BYTES + 2) return SCENE_STAGE_BAD;
+    if (crc16(req, len - 2) != uint16_t(req[len - 2] | (req[len - 1] << 8))) return SCENE_STAGE_BAD;
+    return stageScenes(req + SCENES_REQUEST_HEADER, req[4], req[3], (req[2] & CONTROL_SCENES_PERSIST) != 0);
+}
+#endif
+
+// Control requests are answered straight from the receive task; they never reach the queue.
+static void handleControl(AsyncUDPPacket &dgram) {
+    const uint8_t *req = dgram.data();
+    switch (req[1]) {
+        case CONTROL_CMD_STATS: {
+            uint8_t reply[TELEMETRY_REPLY_SIZE];
+            size_t n = telemetryBuildReply(req[1], (req[2] & CONTROL_STATS_RESET) != 0, reply, sizeof(reply));
+            if (n) dgram.write(reply, n);
+            break;
+        }
+#if ENABLE_CAPTURE_MIRROR
+        case CONTROL_CMD_CAPTURE: {
+            bool on = (req[2] & CONTROL_CAPTURE_ON) != 0;
+            captureIp = dgram.remoteIP();
+            capturePort = on ? dgram.remotePort() : 0;
+            captureUntilMs = millis() + CAPTURE_LEASE_MS;
+            uint8_t ack[3] = {CONTROL_MAGIC, uint8_t(CONTROL_CMD_CAPTURE | CONTROL_REPLY), uint8_t(on ? 1 : 0)};
+            dgram.write(ack, sizeof(ack));
+            break;
+        }
+#endif
+#if ENABLE_COLOR_LUT
+        case CONTROL_CMD_COLOR_LUT: {
+            uint8_t ack[3] = {CONTROL_MAGIC, uint8_t(CONTROL_CMD_COLOR_LUT | CONTROL_REPLY),
+                              handleColorLut(req, dgram.length())};
+            dgram.write(ack, sizeof(ack));
+            break;
+        }
+#endif
+#if ENABLE_SCENE_ENGINE
+        case CONTROL_CMD_SCENES: {
+            uint8_t ack[3] = {CONTROL_MAGIC, uint8_t(CONTROL_CMD_SCENES | CONTROL_REPLY),
+                              handleScenes(req, dgram.length())};
+            dgram.write(ack, sizeof(ack));
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+}
+
+#if ENABLE_CAPTURE_MIRROR
+static void mirrorDatagram(AsyncUDPPacket &dgram, unsigned long arrivalMs) {
+    if (capturePort == 0) return;
+    if (long(arrivalMs - captureUntilMs) > 0) {
+        capturePort = 0;
+        return;
     }
-    Serial.println("\n[WiFi] Connected");
-    Serial.print("[WiFi] SSID: ");
-    Serial.println(WIFI_SSID);
-    Serial.print("[WiFi] IP: ");
-    Serial.println(WiFi.localIP());
-    Serial.print("[WiFi] BSSID: ");
-    Serial.println(WiFi.BSSIDstr());
+    uint8_t buf[CAPTURE_MIRROR_HEADER + CAPTURE_MIRROR_MAX_PAYLOAD];
+    const size_t len = dgram.length();
+    if (len > CAPTURE_MIRROR_MAX_PAYLOAD) return;
+    buf[0] = CONTROL_MAGIC;
+    buf[1] = uint8_t(CONTROL_CMD_CAPTURE | CONTROL_REPLY);
+    buf[2] = 0;
+    for (int i = 0; i < 4; ++i) buf[3 + i] = uint8_t(arrivalMs >> (8 * i));
+    memcpy(buf + CAPTURE_MIRROR_HEADER, dgram.data(), len);
+    udp.writeTo(buf, CAPTURE_MIRROR_HEADER + len, captureIp, capturePort);
 }
+#endif
 
-void setupUDP() {
-    udp.begin(UDP_PORT);
+void setupUDP(void *consumer) {
+    packetConsumer = static_cast<TaskHandle_t>(consumer);
+    if (!udp.listen(UDP_PORT)) {
+        Serial.printf("[UDP] Failed to listen on port %d\n", UDP_PORT);
+        return;
+    }
+#if ENABLE_UDP_MULTICAST
+    // Without a station interface yet the join fails; networkLinkUp() retries it.
+    joinMulticast();
+#endif
+    udp.onPacket([](AsyncUDPPacket &dgram) {
+        if (dgram.length() >= 3 && dgram.data()[0] == CONTROL_MAGIC) {
+            handleControl(dgram);
+            return;
+        }
+        unsigned long arrivalMs = millis();
+#if ENABLE_CAPTURE_MIRROR
+        mirrorDatagram(dgram, arrivalMs);
+#endif
+        Packet packet;
+        uint32_t t0 = telemetryMicros();
+        if (!parsePacket(dgram.data(), dgram.length(), packet)) return;
+        telemetryRecord(TIMING_PARSE, t0);
+        telemetryCount(COUNTER_PACKETS_OK);
+        telemetryNoteSequence(packet.version, packet.seq);
+        if (!pushPacket(packet, arrivalMs)) {
+            telemetryCount(COUNTER_QUEUE_OVERFLOW);
+            return;
+        }
+        if (packetConsumer) xTaskNotifyGive(packetConsumer);
+    });
     Serial.printf("[UDP] Listening on port %d\n", UDP_PORT);
+
+#if ENABLE_RAW_STREAM
+    if (rawUdp.listen(RAW_STREAM_PORT)) {
+        rawUdp.onPacket([](AsyncUDPPacket &dgram) {
+            DdpHeader hdr;
+            if (!parseDdp(dgram.data(), dgram.length(), hdr)) return;
+            writeRawPixels(hdr.offset, hdr.payload, hdr.length);
+            if (hdr.push) {
+                pushRawPixels();
+                telemetryCount(COUNTER_RAW_FRAMES);
+                rawPushMs.store(millis(), std::memory_order_relaxed);
+                rawPushes.fetch_add(1, std::memory_order_release);
+                if (packetConsumer) xTaskNotifyGive(packetConsumer);
+            }
+        });
+        Serial.printf("[DDP] Raw pixel stream on port %d\n", RAW_STREAM_PORT);
+    }
+#endif
+}
+
+void networkLinkUp() {
+#if ENABLE_UDP_MULTICAST
+    if (!multicastJoined.load()) joinMulticast();
+#endif
 }
 
-bool receivePacket(Packet &packet) {
-    int packetSize = udp.parsePacket();
-    if (packetSize != PACKET_SIZE) return false;
-    uint8_t buf[PACKET_SIZE];
-    udp.read(buf, PACKET_SIZE);
-    // Validate header/footer
-    if (buf[0] != 0xAA || buf[11] != 0x55) return false;
-    // Validate checksum
-    uint8_t checksum = 0;
-    for (int i = 1; i <= 9; ++i) checksum ^= buf[i];
-    if (buf[10] != checksum) return false;
-    // Copy to packet
-    packet.mode = buf[1];
-    packet.r = buf[2];
-    packet.g = buf[3];
-    packet.b = buf[4];
-    packet.brightness = buf[5];
-    packet.motion_energy = buf[6];
-    packet.motion_speed = buf[7];
-    packet.motion_direction = buf[8];
-    packet.frame_id = buf[9];
+bool takeRawFrame(unsigned long &arrivalMs) {
+#if ENABLE_RAW_STREAM
+    uint32_t pushes = rawPushes.load(std::memory_order_acquire);
+    if (pushes == rawPushesSeen) return false;
+    rawPushesSeen = pushes;
+    arrivalMs = rawPushMs.load(std::memory_order_relaxed);
     return true;
+#else
+    (void)arrivalMs;
+    return false;
+#endif
 }
@@ -1,7 +1,14 @@
-// network.h
 #pragma once
 #include "state.h"
 
-void setupWiFi();
-void setupUDP();
-bool receivePacket(Packet &packet);
+// Start the event-driven UDP listener. Each valid packet (protocol.h) is queued (packet_queue.h)
+// and `consumer` is woken with a task notification.
+void setupUDP(void *consumer);
+
+// Wi-Fi task, on every (re)connect: joins UDP_MULTICAST_GROUP if that has not worked yet
+// (the group can only be joined once the station interface exists).
+void networkLinkUp();
+
+// Render-task side of the raw pixel stream: true (and the arrival time) when at least one
+// DDP frame was pushed (pushRawPixels) since the last call.
+bool takeRawFrame(unsigned long &arrivalMs);
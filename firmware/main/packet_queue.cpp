@@ -0,0 +1,38 @@
+// packet_queue.cpp
+// Lock-free SPSC ring: the producer only writes head, the consumer only writes tail.
+#include "config.h"
+#include "packet_queue.h"
+#include <atomic>
+
+static_assert((PACKET_QUEUE_LEN & (PACKET_QUEUE_LEN - 1)) == 0, "PACKET_QUEUE_LEN must be a power of two");
+
+struct QueuedPacket {
+    Packet packet;
+    unsigned long arrivalMs;
+};
+
+static QueuedPacket slots[PACKET_QUEUE_LEN];
+static std::atomic<uint32_t> head(0);
+static std::atomic<uint32_t> tail(0);
+
+bool pushPacket(const Packet &packet, unsigned long arrivalMs) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    if (h - t >= PACKET_QUEUE_LEN) return false;
+    QueuedPacket &slot = slots[h & (PACKET_QUEUE_LEN - 1)];
+    slot.packet = packet;
+    slot.arrivalMs = arrivalMs;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool popPacket(Packet &packet, unsigned long &arrivalMs) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+    if (t == h) return false;
+    const QueuedPacket &slot = slots[t & (PACKET_QUEUE_LEN - 1)];
+    packet = slot.packet;
+    arrivalMs = slot.arrivalMs;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
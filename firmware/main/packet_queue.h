@@ -0,0 +1,10 @@
+// packet_queue.h
+// Lock-free single-producer/single-consumer packet handoff (UDP receive task -> render task)
+#pragma once
+#include "state.h"
+
+// Producer side (UDP receive task only). Returns false and drops the packet when full.
+bool pushPacket(const Packet &packet, unsigned long arrivalMs);
+
+// Consumer side (render task only). Returns false when empty.
+bool popPacket(Packet &packet, unsigned long &arrivalMs);
@@ -0,0 +1,275 @@
+// persistence.cpp
+// Coalesced NVS writes for the last good scene, color calibration, scene engine records and
+// the Wi-Fi association cache, off the render and Wi-Fi tasks
+#include <Arduino.h>
+#include "config.h"
+#include "persistence.h"
+#include "state.h"
+#include "storage.h"
+#include "protocol.h"
+#include "color_lut.h"
+#include "scenes.h"
+#include <string.h>
+
+// Scene blob, version 2 (little endian):
+//   0 version | 1-3 r,g,b | 4 brightness | crc16 over all prior bytes
+// Only what applyFallbackScene() restores: the fallback and boot scene has no motion or
+// zones, so storing them would only keep the coalescing timer from ever settling.
+// Version 1 also held mode, speed, direction and zones (header 9 bytes, zones after it); its
+// color and brightness are still read.
+#define SCENE_BLOB_VERSION 2
+#define SCENE_BLOB_LEN 7
+#define SCENE_BLOB_V1_HEADER 9
+
+// Wake-up period of the persistence task when nothing notifies it.
+static const unsigned long kPollMs = 1000;
+
+static TaskHandle_t storageTaskHandle = nullptr;
+static portMUX_TYPE pendingLock = portMUX_INITIALIZER_UNLOCKED;
+
+#if ENABLE_COLOR_LUT
+// Guarded by pendingLock: bit s of lutSave/lutClear = write/remove segment s.
+static ColorLut pendingLuts[SEGMENT_COUNT];
+static uint8_t lutSave = 0;
+static uint8_t lutClear = 0;
+
+static void flushColorLuts() {
+    static ColorLut table; // persistence task only; kept off its stack
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+        const uint8_t bit = uint8_t(1u << s);
+        portENTER_CRITICAL(&pendingLock);
+        const bool save = (lutSave & bit) != 0;
+        const bool clear = (lutClear & bit) != 0;
+        if (save) table = pendingLuts[s];
+        lutSave &= uint8_t(~bit);
+        lutClear &= uint8_t(~bit);
+        portEXIT_CRITICAL(&pendingLock);
+        if (save) {
+            saveColorLut(uint8_t(s), &table.ch[0][0]);
+        } else if (clear) {
+            clearColorLut(uint8_t(s));
+        }
+    }
+}
+#endif
+
+#if ENABLE_WIFI_FAST_CONNECT
+// Guarded by pendingLock: the newest Wi-Fi association not yet written, or a request to
+// forget the stored one (wifiForget).
+static WifiCache pendingWifi;
+static bool wifiDirty = false;
+static bool wifiForget = false;
+
+static void flushWifiCache() {
+    WifiCache cache;
+    portENTER_CRITICAL(&pendingLock);
+    const bool save = wifiDirty;
+    const bool forget = wifiForget;
+    cache = pendingWifi;
+    wifiDirty = false;
+    wifiForget = false;
+    portEXIT_CRITICAL(&pendingLock);
+    if (save) saveWifiCache(cache);
+    else if (forget) clearWifiCache();
+}
+#endif
+
+#if ENABLE_SCENE_ENGINE
+// Guarded by pendingLock: the newest scene list not yet written.
+static uint8_t pendingSceneList[SCENE_LIST_MAX_BYTES];
+static size_t pendingSceneListLen = 0;
+
+static void flushSceneList() {
+    static uint8_t blob[SCENE_LIST_MAX_BYTES]; // persistence task only; kept off its stack
+    portENTER_CRITICAL(&pendingLock);
+    const size_t len = pendingSceneListLen;
+    memcpy(blob, pendingSceneList, len);
+    pendingSceneListLen = 0;
+    portEXIT_CRITICAL(&pendingLock);
+    if (len) saveSceneList(blob, len);
+}
+#endif
+
+#if ENABLE_SCENE_PERSISTENCE
+// Guarded by pendingLock. sceneChangedMs is the latest change, sceneDirtyMs the first one
+// not yet written.
+static uint8_t pendingScene[SCENE_BLOB_MAX];
+static size_t pendingSceneLen = 0;
+static bool sceneDirty = false;
+static unsigned long sceneChangedMs = 0;
+static unsigned long sceneDirtyMs = 0;
+
+static size_t encodeScene(const TargetState &scene, uint8_t *out) {
+    out[0] = SCENE_BLOB_VERSION;
+    out[1] = scene.r;
+    out[2] = scene.g;
+    out[3] = scene.b;
+    out[4] = scene.brightness;
+    const uint16_t crc = crc16(out, SCENE_BLOB_LEN - 2);
+    out[SCENE_BLOB_LEN - 2] = uint8_t(crc & 0xFF);
+    out[SCENE_BLOB_LEN - 1] = uint8_t(crc >> 8);
+    return SCENE_BLOB_LEN;
+}
+
+static bool decodeScene(const uint8_t *blob, size_t len, TargetState &scene) {
+    if (len < 3 || crc16(blob, len - 2) != uint16_t(blob[len - 2] | (blob[len - 1] << 8))) return false;
+    const uint8_t *color;
+    if (blob[0] == SCENE_BLOB_VERSION && len == SCENE_BLOB_LEN) {
+        color = blob + 1;
+    } else if (blob[0] == 1 && len >= SCENE_BLOB_V1_HEADER + 2 && blob[8] <= MAX_ZONES &&
+               len == SCENE_BLOB_V1_HEADER + size_t(blob[8]) * 3 + 2) {
+        color = blob + 2;
+    } else {
+        return false;
+    }
+    scene = lastGoodScene(); // the defaults for everything not stored
+    scene.r = color[0];
+    scene.g = color[1];
+    scene.b = color[2];
+    scene.brightness = color[3];
+    return true;
+}
+
+// Persistence task only: what NVS holds now.
+static uint8_t storedScene[SCENE_BLOB_MAX];
+static size_t storedSceneLen = 0;
+static bool wroteScene = false;
+static unsigned long lastWriteMs = 0;
+
+static void flushScene(unsigned long nowMs) {
+    if (wroteScene && nowMs - lastWriteMs < SCENE_SAVE_MIN_INTERVAL_MS) return;
+    uint8_t blob[SCENE_BLOB_MAX];
+    size_t len = 0;
+    portENTER_CRITICAL(&pendingLock);
+    // Wait for the scene to settle, but don't let a never-settling one go unsaved forever.
+    if (sceneDirty && (nowMs - sceneChangedMs >= SCENE_SAVE_STABLE_MS ||
+                       nowMs - sceneDirtyMs >= SCENE_SAVE_MAX_DEFER_MS)) {
+        len = pendingSceneLen;
+        memcpy(blob, pendingScene, len);
+        sceneDirty = false;
+    }
+    portEXIT_CRITICAL(&pendingLock);
+    if (len == 0) return;
+    if (len == storedSceneLen && memcmp(blob, storedScene, len) == 0) return; // back where it was
+    saveSceneBlob(blob, len);
+    memcpy(storedScene, blob, len);
+    storedSceneLen = len;
+    wroteScene = true;
+    lastWriteMs = nowMs;
+}
+#endif
+
+static void storageTask(void * /*arg*/) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kPollMs));
+#if ENABLE_COLOR_LUT
+        flushColorLuts();
+#endif
+#if ENABLE_WIFI_FAST_CONNECT
+        flushWifiCache();
+#endif
+#if ENABLE_SCENE_ENGINE
+        flushSceneList();
+#endif
+#if ENABLE_SCENE_PERSISTENCE
+        flushScene(millis());
+#endif
+    }
+}
+
+bool persistenceBegin() {
+    bool restored = false;
+#if ENABLE_SCENE_PERSISTENCE
+    TargetState scene;
+    storedSceneLen = loadSceneBlob(storedScene, sizeof(storedScene));
+    if (storedSceneLen > 0 && decodeScene(storedScene, storedSceneLen, scene)) {
+        setLastGoodScene(scene);
+        restored = true;
+    } else {
+        storedSceneLen = 0;
+    }
+#endif
+#if ENABLE_SCENE_ENGINE
+    {
+        uint8_t list[SCENE_LIST_MAX_BYTES];
+        const size_t len = loadSceneList(list, sizeof(list));
+        if (len > 0 && decodeSceneList(list, len)) Serial.println("[SCENE] Scene records restored");
+    }
+#endif
+    xTaskCreatePinnedToCore(storageTask, "storage", STORAGE_TASK_STACK, nullptr, STORAGE_TASK_PRIORITY,
+                            &storageTaskHandle, STORAGE_TASK_CORE);
+    return restored;
+}
+
+void persistenceNoteScene(unsigned long nowMs) {
+#if ENABLE_SCENE_ENGINE
+    if (takeScenePersistRequest()) {
+        uint8_t list[SCENE_LIST_MAX_BYTES];
+        const size_t len = encodeSceneList(list);
+        portENTER_CRITICAL(&pendingLock);
+        memcpy(pendingSceneList, list, len);
+        pendingSceneListLen = len;
+        portEXIT_CRITICAL(&pendingLock);
+        if (storageTaskHandle) xTaskNotifyGive(storageTaskHandle);
+    }
+#endif
+#if ENABLE_SCENE_PERSISTENCE
+    // Render task only. Packets arrive at ~25 Hz; a few checks per second are plenty.
+    static unsigned long lastCheckMs = 0;
+    static uint8_t noted[SCENE_BLOB_MAX];
+    static size_t notedLen = 0;
+    if (notedLen != 0 && nowMs - lastCheckMs < 250) return;
+    lastCheckMs = nowMs;
+    // The first call records the restored (or default) scene, which is already stored.
+    if (notedLen == 0) notedLen = encodeScene(lastGoodScene(), noted);
+
+    uint8_t blob[SCENE_BLOB_MAX];
+    const size_t len = encodeScene(lastGoodScene(), blob);
+    if (len == notedLen && memcmp(blob, noted, len) == 0) return;
+    memcpy(noted, blob, len);
+    notedLen = len;
+    portENTER_CRITICAL(&pendingLock);
+    memcpy(pendingScene, blob, len);
+    pendingSceneLen = len;
+    if (!sceneDirty) sceneDirtyMs = nowMs;
+    sceneChangedMs = nowMs;
+    sceneDirty = true;
+    portEXIT_CRITICAL(&pendingLock);
+#else
+    (void)nowMs;
+#endif
+}
+
+void persistColorLut(uint8_t segment, const uint8_t *table) {
+#if ENABLE_COLOR_LUT
+    if (segment >= SEGMENT_COUNT) return;
+    const uint8_t bit = uint8_t(1u << segment);
+    portENTER_CRITICAL(&pendingLock);
+    if (table) {
+        memcpy(pendingLuts[segment].ch, table, COLOR_LUT_BYTES);
+        lutSave |= bit;
+        lutClear &= uint8_t(~bit);
+    } else {
+        lutClear |= bit;
+        lutSave &= uint8_t(~bit);
+    }
+    portEXIT_CRITICAL(&pendingLock);
+    if (storageTaskHandle) xTaskNotifyGive(storageTaskHandle);
+#else
+    (void)segment;
+    (void)table;
+#endif
+}
+
+void persistWifiCache(const WifiCache *cache) {
+#if ENABLE_WIFI_FAST_CONNECT
+    portENTER_CRITICAL(&pendingLock);
+    if (cache) pendingWifi = *cache;
+    wifiDirty = cache != nullptr;
+    wifiForget = cache == nullptr;
+    portEXIT_CRITICAL(&pendingLock);
+    if (storageTaskHandle) xTaskNotifyGive(storageTaskHandle);
+#else
+    (void)cache;
+#endif
+}
@@ -0,0 +1,26 @@
+// persistence.h
+// Coalesced NVS writes for the last good scene, color calibration, scene engine records and
+// the Wi-Fi association cache, off the render and Wi-Fi tasks
+#pragma once
+#include <cstdint>
+#include "storage.h"
+
+// Restore the last good scene from NVS into lastGoodScene() (returns false if none was
+// stored or it did not validate) and the scene engine records, then start the persistence
+// task. Call before initState().
+bool persistenceBegin();
+
+// Render task, once per loop: picks up changes to lastGoodScene() and scene uploads that
+// asked to persist. Cheap when nothing
+// changed; the write itself happens later in the persistence task.
+void persistenceNoteScene(unsigned long nowMs);
+
+// Any task: store `table` (COLOR_LUT_BYTES) as the saved LUT for `segment`, or forget the
+// saved one when `table` is null. Written on the persistence task's next pass; a newer
+// request for the same segment replaces one not yet written.
+void persistColorLut(uint8_t segment, const uint8_t *table);
+
+// Any task: store `cache` as the Wi-Fi association for fast reconnects (wifi_link.cpp), or
+// forget the stored one when `cache` is null. Written on the persistence task's next pass; a
+// newer request replaces one not yet written.
+void persistWifiCache(const WifiCache *cache);
@@ -0,0 +1,67 @@
+// power_meter.cpp
+// Per-segment LED current estimate and limiter
+#include "config.h"
+#include "power_meter.h"
+#include "color_lut.h"
+#include <algorithm>
+
+PowerMeter framePower;
+
+// Output task only. Stored as the reduction below full scale so zero-init means "no limit".
+static uint8_t scaleReduction[SEGMENT_COUNT];
+static unsigned long lastUpdateMs = 0;
+
+uint32_t estimateSegmentMa(const PowerSums &sums, int segment, uint8_t brightness, const uint16_t gainQ8[3]) {
+    static const uint32_t kChannelMa[3] = {POWER_MA_RED, POWER_MA_GREEN, POWER_MA_BLUE};
+    uint64_t weighted = 0;
+    for (int c = 0; c < 3; ++c) {
+        weighted += uint64_t(sums.ch[segment][c]) * gainQ8[c] * kChannelMa[c];
+    }
+    // Sums are 0..255 per LED, gain is Q8 and brightness scales the whole frame.
+    const uint64_t colorMa = weighted * brightness / (256ULL * 255 * 255);
+    return uint32_t(POWER_MA_IDLE) * kSegments[segment].count + uint32_t(colorMa);
+}
+
+void powerLimiterUpdate(const PowerSums &sums, uint8_t brightness, unsigned long nowMs,
+                        uint8_t scales[SEGMENT_COUNT]) {
+    const unsigned long dt = nowMs - lastUpdateMs;
+    lastUpdateMs = nowMs;
+    const uint32_t recover = POWER_RELEASE_MS > 0 ? uint32_t(std::min(dt, 1000UL) * 255UL / POWER_RELEASE_MS) : 255;
+
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+#if ENABLE_COLOR_LUT
+        const uint16_t *gain = colorLutGainQ8(uint8_t(s));
+#else
+        static const uint16_t kUnityGain[3] = {256, 256, 256};
+        const uint16_t *gain = kUnityGain;
+#endif
+        const uint32_t idleMa = uint32_t(POWER_MA_IDLE) * kSegments[s].count;
+        const uint32_t totalMa = estimateSegmentMa(sums, s, brightness, gain);
+        const uint32_t colorMa = totalMa - idleMa;
+        // Color current scales linearly with the per-segment scale; idle current does not.
+        uint32_t target = 255;
+        if (totalMa > POWER_SEGMENT_LIMIT_MA && colorMa > 0) {
+            target = POWER_SEGMENT_LIMIT_MA > idleMa ? (POWER_SEGMENT_LIMIT_MA - idleMa) * 255 / colorMa : 0;
+        }
+        uint32_t current = 255u - scaleReduction[s];
+        if (target < current) {
+            current = target; // over budget: cut this frame
+        } else {
+            current = std::min(target, current + recover);
+        }
+        scaleReduction[s] = uint8_t(255u - current);
+        scales[s] = uint8_t(current);
+    }
+}
+
+void copyScaled(const CRGB *src, CRGB *dst, size_t count, uint8_t scale) {
+    if (scale == 255) {
+        memcpy(dst, src, count * sizeof(CRGB));
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        dst[i].r = scale8(src[i].r, scale);
+        dst[i].g = scale8(src[i].g, scale);
+        dst[i].b = scale8(src[i].b, scale);
+    }
+}
@@ -0,0 +1,72 @@
+// power_meter.h
+// Per-segment LED current estimate, gathered while the kernels write the frame
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+#include <FastLED.h>
+#include "config.h"
+#include "segments.h"
+
+// Per-segment sums of the rendered channel values (before LUT and brightness) of one frame.
+struct PowerSums {
+    uint32_t ch[SEGMENT_COUNT][3];
+};
+
+// Fed every pixel of a frame exactly once, in LED order, which is the order the kernels write
+// leds[] in. Costs three adds and a countdown per pixel. Pixels added past the last segment
+// are dropped, so a caller that overruns NUM_LEDS cannot write past the sums.
+class PowerMeter {
+public:
+    void begin() {
+        memset(&sums_, 0, sizeof(sums_));
+        segment_ = 0;
+        left_ = kSegments[0].count;
+    }
+
+    inline void add(const CRGB &px) {
+        if (segment_ >= SEGMENT_COUNT) return;
+        uint32_t *sum = sums_.ch[segment_];
+        sum[0] += px.r;
+        sum[1] += px.g;
+        sum[2] += px.b;
+        if (--left_ == 0) nextSegment();
+    }
+
+    // True once every LED has been added since begin().
+    bool complete() const { return segment_ >= SEGMENT_COUNT; }
+    void invalidate() { segment_ = 0; left_ = 0xFFFF; }
+    const PowerSums &sums() const { return sums_; }
+
+    // Separate pass for frames that did not come from a metered kernel (raw stream).
+    void measure(const CRGB *frame) {
+        begin();
+        for (int i = 0; i < NUM_LEDS; ++i) add(frame[i]);
+    }
+
+private:
+    void nextSegment() {
+        ++segment_;
+        left_ = segment_ < SEGMENT_COUNT ? kSegments[segment_].count : 0xFFFF;
+    }
+
+    PowerSums sums_;
+    uint8_t segment_ = 0;
+    uint16_t left_ = 0xFFFF;
+};
+
+// Meter for the frame in the back buffer. Written by renderFrame(), read by presentFrame().
+extern PowerMeter framePower;
+
+// Estimated draw of `segment` in mA: idle current plus each channel's full-scale current,
+// weighted by its rendered sum, the channel's LUT gain (Q8, 256 = 1:1) and the brightness.
+uint32_t estimateSegmentMa(const PowerSums &sums, int segment, uint8_t brightness, const uint16_t gainQ8[3]);
+
+// Per-segment scale (255 = none) that keeps each segment under POWER_SEGMENT_LIMIT_MA. Drops
+// at once when a frame would exceed the budget and recovers over POWER_RELEASE_MS. Output
+// task only.
+void powerLimiterUpdate(const PowerSums &sums, uint8_t brightness, unsigned long nowMs,
+                        uint8_t scales[SEGMENT_COUNT]);
+
+// dst = src * scale / 256 (scale8) for `count` pixels.
+void copyScaled(const CRGB *src, CRGB *dst, size_t count, uint8_t scale);
@@ -0,0 +1,133 @@
+// protocol.cpp
+// Packet validation and unpacking for protocol v1 and v2
+#include "config.h"
+#include "protocol.h"
+#include "telemetry.h"
+#include <string.h>
+
+uint16_t crc16(const uint8_t *buf, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= uint16_t(buf[i]) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? uint16_t((crc << 1) ^ 0x1021) : uint16_t(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline uint16_t readU16(const uint8_t *p) {
+    return uint16_t(p[0]) | (uint16_t(p[1]) << 8);
+}
+
+static inline uint32_t readU32(const uint8_t *p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static inline bool malformed() {
+    telemetryCount(COUNTER_BAD_FORMAT);
+    return false;
+}
+
+static bool parsePacketV1(const uint8_t *buf, Packet &packet) {
+    // Validate header/footer
+    if (buf[0] != 0xAA || buf[11] != 0x55) return malformed();
+    // Validate checksum
+    uint8_t checksum = 0;
+    for (int i = 1; i <= 9; ++i) checksum ^= buf[i];
+    if (buf[10] != checksum) {
+        telemetryCount(COUNTER_BAD_CHECKSUM);
+        return false;
+    }
+    // Copy to packet
+    packet.version = 1;
+    packet.flags = 0;
+    packet.mode = buf[1];
+    packet.r = buf[2];
+    packet.g = buf[3];
+    packet.b = buf[4];
+    packet.brightness = buf[5];
+    packet.motion_energy = buf[6];
+    packet.motion_speed = buf[7];
+    packet.motion_direction = buf[8];
+    packet.frame_id = buf[9];
+    packet.seq = buf[9];
+    packet.sender_ms = 0;
+    packet.zone_count = 0;
+    packet.sync_delay_ms = 0;
+    packet.beat_strength = 0;
+    return true;
+}
+
+static bool parsePacketV2(const uint8_t *buf, size_t len, Packet &packet) {
+    if (buf[1] != PACKET_V2_VERSION) return malformed();
+    if (crc16(buf, len - 2) != readU16(buf + len - 2)) {
+        telemetryCount(COUNTER_BAD_CHECKSUM);
+        return false;
+    }
+    packet.version = buf[1];
+    packet.flags = buf[2];
+    packet.mode = buf[3];
+    packet.r = buf[4];
+    packet.g = buf[5];
+    packet.b = buf[6];
+    packet.brightness = buf[7];
+    packet.motion_energy = buf[8];
+    packet.motion_speed = buf[9];
+    packet.motion_direction = buf[10];
+    packet.seq = readU16(buf + 11);
+    packet.frame_id = uint8_t(packet.seq);
+    packet.sender_ms = readU32(buf + 13);
+    packet.zone_count = 0;
+    packet.sync_delay_ms = 0;
+    packet.beat_strength = 0;
+
+    // Extensions
+    const uint8_t *ext = buf + 17;
+    const uint8_t *end = buf + len - 2;
+    if (packet.flags & PACKET_FLAG_ZONES) {
+        if (ext >= end) return malformed();
+        uint8_t count = *ext++;
+        if (count > MAX_ZONES || size_t(end - ext) < size_t(count) * 3) return malformed();
+        memcpy(packet.zones, ext, size_t(count) * 3);
+        packet.zone_count = count;
+        ext += size_t(count) * 3;
+    }
+    if (packet.flags & PACKET_FLAG_SYNC) {
+        if (ext >= end) return malformed();
+        packet.sync_delay_ms = *ext++;
+    }
+    if (packet.flags & PACKET_FLAG_BEAT) {
+        if (end - ext < 3) return malformed();
+        packet.beat_id = ext[0];
+        packet.beat_strength = ext[1];
+        packet.beat_age_ms = ext[2];
+        ext += 3;
+    }
+    return true;
+}
+
+bool parsePacket(const uint8_t *buf, size_t len, Packet &packet) {
+    if (len == PACKET_SIZE && buf[0] == 0xAA) return parsePacketV1(buf, packet);
+    if (len >= PACKET_V2_BASE_SIZE && buf[0] == PACKET_V2_MAGIC) return parsePacketV2(buf, len, packet);
+    return malformed();
+}
+
+static inline uint32_t readU32BE(const uint8_t *p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+bool parseDdp(const uint8_t *buf, size_t len, DdpHeader &hdr) {
+    if (len < 10) return false;
+    const uint8_t flags = buf[0];
+    if ((flags & 0xC0) != 0x40) return false;   // DDP version 1 only
+    if (flags & (0x02 | 0x04)) return false;    // queries/replies carry no pixels
+    const size_t headerLen = (flags & 0x10) ? 14 : 10;
+    if (len < headerLen) return false;
+    hdr.offset = readU32BE(buf + 4);
+    hdr.length = uint16_t((uint16_t(buf[8]) << 8) | buf[9]);
+    if (hdr.length > len - headerLen) return false;
+    hdr.push = (flags & 0x01) != 0;
+    hdr.payload = buf + headerLen;
+    return true;
+}
@@ -0,0 +1,72 @@
+// protocol.h
+// Wire formats for laptop -> ESP32 packets
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "state.h"
+
+// v1 (12 bytes): AA mode r g b bright motionE speed dir frame_id xor 55
+// v2 (19+ bytes, multi-byte fields little-endian):
+//   0 magic A5 | 1 version 02 | 2 flags | 3 mode | 4-6 r g b | 7 bright
+//   8 motionE | 9 speed | 10 dir | 11-12 seq | 13-16 sender_ms | [extensions] | crc16
+// The CRC (CCITT-FALSE) covers every byte before it. Unknown trailing extension bytes are
+// ignored so older firmware keeps accepting newer senders.
+#define PACKET_V2_MAGIC      0xA5
+#define PACKET_V2_VERSION    2
+#define PACKET_V2_BASE_SIZE  19
+
+// v2 extension flags (byte 2). Present extensions follow byte 16 in bit order.
+#define PACKET_FLAG_ZONES    0x01  // [count][count x r g b], count <= MAX_ZONES
+#define PACKET_FLAG_SYNC     0x02  // [present delay ms]: fan-out to several units, see jitter_buffer.h
+#define PACKET_FLAG_BEAT     0x04  // [beat id][strength][age ms before sender_ms]: audio onset, see state.h
+
+// Control datagrams on UDP_PORT (laptop -> ESP32, answered to the sender's address):
+//   0 magic A6 | 1 command | 2 command flags. Replies echo the command with CONTROL_REPLY set.
+#define CONTROL_MAGIC        0xA6
+#define CONTROL_REPLY        0x80
+#define CONTROL_CMD_STATS    0x01  // reply: telemetry snapshot (telemetry.h)
+#define CONTROL_STATS_RESET  0x01  // flag: zero counters/histograms after the snapshot
+#define CONTROL_CMD_CAPTURE  0x02  // mirror received packets back to the requester
+#define CONTROL_CAPTURE_ON   0x01  // flag: start/renew the capture lease (clear = stop)
+#define CONTROL_CMD_COLOR_LUT 0x03 // load a segment's gamma/white-balance LUT (color_lut.h)
+#define CONTROL_LUT_PERSIST  0x01  // flag: also store it in NVS (or erase NVS with DEFAULT)
+#define CONTROL_LUT_DEFAULT  0x02  // flag: go back to the built-in table (no table bytes)
+#define CONTROL_CMD_SCENES   0x04  // load the scene engine's records or pick the active one (scenes.h)
+#define CONTROL_SCENES_PERSIST 0x01 // flag: also store the result in NVS
+
+// Color LUT request: 0 A6 | 1 CONTROL_CMD_COLOR_LUT | 2 flags | 3 segment
+//   4.. COLOR_LUT_BYTES table (omitted with CONTROL_LUT_DEFAULT) | crc16 over all prior bytes
+// Reply: 0 A6 | 1 CONTROL_CMD_COLOR_LUT|CONTROL_REPLY | 2 CONTROL_LUT_OK/BAD/BUSY
+#define COLOR_LUT_REQUEST_HEADER 4
+#define CONTROL_LUT_OK       0
+#define CONTROL_LUT_BAD      1     // wrong size, CRC or segment
+#define CONTROL_LUT_BUSY     2     // previous upload for the segment not applied yet; retry
+
+// Scene request: 0 A6 | 1 CONTROL_CMD_SCENES | 2 flags | 3 active index | 4 count
+//   5.. count * SCENE_RECORD_BYTES records (count 0 = only select `active`) | crc16 over all prior bytes
+// Reply: 0 A6 | 1 CONTROL_CMD_SCENES|CONTROL_REPLY | 2 SCENE_STAGE_OK/BAD/BUSY (scenes.h)
+#define SCENES_REQUEST_HEADER 5
+
+// Capture mirror datagram (ESP32 -> requester), one per received packet:
+//   0 A6 | 1 CONTROL_CMD_CAPTURE|CONTROL_REPLY | 2 channel (0 = UDP_PORT) | 3-6 arrival ms (LE)
+//   7.. the datagram exactly as received (including corrupt ones)
+#define CAPTURE_MIRROR_HEADER 7
+
+uint16_t crc16(const uint8_t *buf, size_t len);
+
+// Validate a raw datagram (v1 or v2) and unpack it. No I/O; safe to call from any task.
+bool parsePacket(const uint8_t *buf, size_t len, Packet &packet);
+
+// DDP (Distributed Display Protocol) raw pixel datagram, UDP port RAW_STREAM_PORT:
+//   0 flags (ver 0x40, PUSH 0x01, QUERY 0x02, REPLY 0x04, TIMECODE 0x10) | 1 seq
+//   2 data type | 3 destination id | 4-7 byte offset (BE) | 8-9 payload length (BE)
+//   [10-13 timecode when flagged] | payload = RGB bytes
+// Large frames span several datagrams; the one with PUSH set completes the frame.
+struct DdpHeader {
+    uint32_t offset;          // byte offset into the RGB frame
+    uint16_t length;          // payload bytes
+    bool push;                // frame complete: present it
+    const uint8_t *payload;   // points into the caller's datagram (no copy)
+};
+
+bool parseDdp(const uint8_t *buf, size_t len, DdpHeader &hdr);
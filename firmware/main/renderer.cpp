@@ -4,33 +4,283 @@
 #include "config.h"
 #include "state.h"
 #include "modes.h"
+#include "renderer.h"
+#include "segments.h"
+#include "storage.h"
+#include "telemetry.h"
+#include "color_lut.h"
+#include "power_meter.h"
+#include "dither.h"
 #include <FastLED.h>
+#include <string.h>
 
-CRGB leds[NUM_LEDS];
+// Double-buffered frame: the modes write the back buffer through `leds` while the
+// output task transmits the front buffer over RMT (all segments in parallel). The other
+// two buffers belong to the raw pixel stream; all four change roles by pointer swaps only.
+static CRGB frameBuffers[4][NUM_LEDS];
+CRGB *leds = frameBuffers[0];
+static CRGB *frontBuffer = frameBuffers[1];
+#if ENABLE_COLOR_LUT || ENABLE_SEGMENT_POWER_LIMIT || ENABLE_TEMPORAL_DITHER
+#define OUTPUT_WIRE_BUFFER 1
+// What the RMT controllers actually transmit: the front buffer after the color LUT, the
+// per-segment power scale and (with ENABLE_TEMPORAL_DITHER) the dithered brightness. Keeping
+// it separate leaves the front buffer as rendered, so the dirty-frame compare still works.
+static CRGB wireBuffer[NUM_LEDS];
+#else
+#define OUTPUT_WIRE_BUFFER 0
+#endif
+#if ENABLE_TEMPORAL_DITHER
+static DitherResidual ditherResidual; // output task only
+static bool ditherPending = false;    // the front buffer has fractions left to show (output task)
+#if DITHER_REFRESH_FRAMES > 0
+static uint16_t ditherRefreshes = 0; // re-sends of the current front buffer (output task)
+#endif
+#endif
+
+static uint8_t backBrightness = 255;
+static uint8_t frontBrightness = 255;
+#if ENABLE_SEGMENT_POWER_LIMIT
+static PowerSums frontPower; // power meter sums of the front buffer
+#endif
+
+static unsigned long lastShowMs = 0;
+
+static CLEDController *segmentControllers[SEGMENT_COUNT];
+
+// Raw pixel stream: DDP chunks are written straight into rawFill (UDP receive task only); a
+// PUSH swaps it with rawReady, and the render task swaps rawReady in as the back buffer when
+// it presents. Neither kernel frames nor the next frame's chunks can tear a raw frame.
+struct RawFrame {
+    CRGB *pixels;
+    uint32_t begin, end; // byte range the frame's chunks covered; begin == end: none yet
+};
+static RawFrame rawFill = {frameBuffers[2], 0, 0};
+static RawFrame rawReady = {frameBuffers[3], 0, 0};
+static bool rawReadyFresh = false; // rawReady holds a pushed frame not presented yet
+
+// Guards the buffer swap and rawReady between the UDP receive task and the render task.
+static portMUX_TYPE bufferLock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t outputTaskHandle = nullptr;
+static SemaphoreHandle_t outputIdle = nullptr; // given when the front buffer may be replaced
+
+#if OUTPUT_WIRE_BUFFER
+// `fresh` = a new front buffer; false when re-sending the same one for the dither.
+static void writeWireBuffer(bool fresh) {
+    uint8_t scales[SEGMENT_COUNT];
+#if ENABLE_COLOR_LUT
+    commitStagedColorLuts(); // before the limiter, which reads the tables' gains
+#endif
+#if ENABLE_SEGMENT_POWER_LIMIT
+    powerLimiterUpdate(frontPower, frontBrightness, millis(), scales);
+#else
+    memset(scales, 255, sizeof(scales));
+#endif
+    bool limited = false;
+#if ENABLE_TEMPORAL_DITHER
+    ditherPending = false;
+#endif
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+        const CRGB *src = frontBuffer + kSegments[s].offset;
+        CRGB *dst = wireBuffer + kSegments[s].offset;
+#if ENABLE_TEMPORAL_DITHER
+        uint8_t(*residual)[3] = ditherResidual.ch + kSegments[s].offset;
+        const uint32_t gain = ditherGain(frontBrightness, scales[s]);
+#if ENABLE_COLOR_LUT
+        ditherPending |= applyColorLutDithered(colorLut(s), src, dst, residual, kSegments[s].count, gain);
+#else
+        ditherPending |= copyDithered(src, dst, residual, kSegments[s].count, gain);
+#endif
+#elif ENABLE_COLOR_LUT
+        applyColorLut(colorLut(s), src, dst, kSegments[s].count, scales[s]);
+#else
+        copyScaled(src, dst, kSegments[s].count, scales[s]);
+#endif
+        limited |= scales[s] < 255;
+    }
+    if (limited && fresh) telemetryCount(COUNTER_POWER_LIMITED);
+}
+#endif
+
+static void outputTask(void * /*arg*/) {
+    for (;;) {
+#if ENABLE_TEMPORAL_DITHER && DITHER_REFRESH_FRAMES > 0
+        // A frame with fractions left is re-sent up to DITHER_REFRESH_FRAMES times before the
+        // next one arrives (dirty skips, scene engine frames). The re-send holds outputIdle
+        // like a new frame does; if the render task already holds it, its frame is on the way.
+        const bool refresh = ditherPending && ditherRefreshes < DITHER_REFRESH_FRAMES;
+        const bool fresh = ulTaskNotifyTake(pdTRUE, refresh ? pdMS_TO_TICKS(DITHER_REFRESH_MS) : portMAX_DELAY) != 0;
+        if (!fresh && xSemaphoreTake(outputIdle, 0) != pdTRUE) continue;
+        ditherRefreshes = fresh ? 0 : ditherRefreshes + 1;
+#elif ENABLE_TEMPORAL_DITHER
+        // Fractions carry over between transmitted frames only; a static frame is not re-sent.
+        const bool fresh = ulTaskNotifyTake(pdTRUE, portMAX_DELAY) != 0;
+#else
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const bool fresh = true;
+        FastLED.setBrightness(frontBrightness);
+#endif
+        uint32_t t0 = telemetryMicros();
+#if OUTPUT_WIRE_BUFFER
+        writeWireBuffer(fresh);
+#else
+        (void)fresh;
+#endif
+        FastLED.show();
+        telemetryRecord(TIMING_SHOW, t0);
+        xSemaphoreGive(outputIdle);
+    }
+}
+
+#if ENABLE_COLOR_LUT
+static void setupColorLuts() {
+    ColorLut lut;
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+        if (!loadColorLut(s, &lut.ch[0][0])) buildDefaultColorLut(lut);
+        installColorLut(s, &lut.ch[0][0]);
+    }
+}
+#endif
 
 void setupLEDs() {
-    FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
+#if ENABLE_COLOR_LUT
+    setupColorLuts();
+#endif
+#if ENABLE_TEMPORAL_DITHER
+    initDitherResidual(ditherResidual);
+#endif
+#if OUTPUT_WIRE_BUFFER
+    CRGB *controllerLeds = wireBuffer; // fixed; the output task fills it from the front buffer
+#else
+    CRGB *controllerLeds = frontBuffer;
+#endif
+    // One controller per segment, all views into the same logical buffer.
+    segmentControllers[0] = &FastLED.addLeds<LED_TYPE, SEGMENT0_PIN, COLOR_ORDER>(controllerLeds, kSegments[0].offset, kSegments[0].count);
+#if SEGMENT_COUNT > 1
+    segmentControllers[1] = &FastLED.addLeds<LED_TYPE, SEGMENT1_PIN, COLOR_ORDER>(controllerLeds, kSegments[1].offset, kSegments[1].count);
+#endif
+#if SEGMENT_COUNT > 2
+    segmentControllers[2] = &FastLED.addLeds<LED_TYPE, SEGMENT2_PIN, COLOR_ORDER>(controllerLeds, kSegments[2].offset, kSegments[2].count);
+#endif
+#if SEGMENT_COUNT > 3
+    segmentControllers[3] = &FastLED.addLeds<LED_TYPE, SEGMENT3_PIN, COLOR_ORDER>(controllerLeds, kSegments[3].offset, kSegments[3].count);
+#endif
     #if DISABLE_POWER_LIMIT
     FastLED.setMaxPowerInVoltsAndMilliamps(LED_VOLTAGE, 100000); // effectively uncapped; ensure PSU/wiring are safe
-    #else
+    #elif !ENABLE_SEGMENT_POWER_LIMIT
     FastLED.setMaxPowerInVoltsAndMilliamps(LED_VOLTAGE, POWER_LIMIT_MA);
-    #endif
+    #endif // else: limited per segment in the output task (power_meter.h)
+#if ENABLE_COLOR_LUT
+    // White balance (and gamma) live in the per-segment LUT.
+    FastLED.setCorrection(UncorrectedColor);
+    FastLED.setTemperature(UncorrectedTemperature);
+#else
     FastLED.setCorrection(LED_CORRECTION);
     FastLED.setTemperature(LED_TEMPERATURE);
+#endif
+#if ENABLE_TEMPORAL_DITHER
+    // Brightness and dithering happen in the output stage (dither.h); FastLED sends as is.
+    FastLED.setDither(DISABLE_DITHER);
+    FastLED.setBrightness(255);
+#else
     FastLED.setDither(1);
     FastLED.setBrightness(255); // start at full scale; per-mode calls will adjust dynamically
+#endif
     FastLED.clear();
     FastLED.show();
+    initModes();
+
+    outputIdle = xSemaphoreCreateBinary();
+    xSemaphoreGive(outputIdle);
+    xTaskCreatePinnedToCore(outputTask, "ledout", OUTPUT_TASK_STACK, nullptr,
+                            OUTPUT_TASK_PRIORITY, &outputTaskHandle, OUTPUT_TASK_CORE);
+}
+
+void setFrameBrightness(uint8_t brightness) {
+    backBrightness = brightness;
 }
 
-void renderFrame() {
-    switch (targetState.mode) {
-        case 1: renderMode1(); break;
-        case 2: renderMode2(); break;
-        case 3: renderMode3(); break;
-        case 4: renderMode4(); break;
-        case 5: renderMode5(); break;
-        default: renderMode4(); break;
+void presentFrame() {
+#if ENABLE_SEGMENT_POWER_LIMIT
+    // Kernel frames arrive metered (renderFrame); raw stream frames need their own pass.
+    if (!framePower.complete()) framePower.measure(leds);
+#endif
+#if ENABLE_DIRTY_FRAME_SKIP
+    // The front buffer is only read while it is transmitted, so comparing against it is safe.
+    unsigned long nowMs = millis();
+    bool refreshDue = FORCED_REFRESH_MS > 0 && nowMs - lastShowMs >= FORCED_REFRESH_MS;
+    if (!refreshDue && backBrightness == frontBrightness &&
+        memcmp(leds, frontBuffer, sizeof(CRGB) * NUM_LEDS) == 0) {
+        telemetryCount(COUNTER_FRAMES_SKIPPED);
+#if ENABLE_SEGMENT_POWER_LIMIT
+        framePower.invalidate();
+#endif
+        return; // strip already shows this frame; the back buffer is simply re-rendered next time
     }
-    FastLED.show();
+    lastShowMs = nowMs;
+#endif
+    // Frame N must be fully on the wire before its buffer becomes the next back buffer.
+    xSemaphoreTake(outputIdle, portMAX_DELAY);
+    portENTER_CRITICAL(&bufferLock);
+    CRGB *finished = leds;
+    leds = frontBuffer;
+    frontBuffer = finished;
+    portEXIT_CRITICAL(&bufferLock);
+    frontBrightness = backBrightness;
+#if ENABLE_SEGMENT_POWER_LIMIT
+    frontPower = framePower.sums();
+    framePower.invalidate();
+#endif
+#if !OUTPUT_WIRE_BUFFER
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+        segmentControllers[s]->setLeds(frontBuffer + kSegments[s].offset, kSegments[s].count);
+    }
+#endif
+    xTaskNotifyGive(outputTaskHandle);
+}
+
+void writeRawPixels(uint32_t byteOffset, const uint8_t *rgb, size_t len) {
+    const size_t frameBytes = sizeof(CRGB) * NUM_LEDS;
+    if (byteOffset >= frameBytes || len == 0) return;
+    if (len > frameBytes - byteOffset) len = frameBytes - byteOffset;
+    memcpy(reinterpret_cast<uint8_t *>(rawFill.pixels) + byteOffset, rgb, len);
+    const uint32_t end = byteOffset + uint32_t(len);
+    if (rawFill.begin == rawFill.end) {
+        rawFill.begin = byteOffset;
+        rawFill.end = end;
+    } else {
+        if (byteOffset < rawFill.begin) rawFill.begin = byteOffset;
+        if (end > rawFill.end) rawFill.end = end;
+    }
+}
+
+void pushRawPixels() {
+    portENTER_CRITICAL(&bufferLock);
+    const RawFrame pushed = rawFill;
+    rawFill = rawReady; // a frame pushed before this one and never presented is dropped
+    rawReady = pushed;
+    rawReadyFresh = true;
+    portEXIT_CRITICAL(&bufferLock);
+    rawFill.begin = rawFill.end = 0;
+}
+
+void presentRawFrame() {
+    portENTER_CRITICAL(&bufferLock);
+    if (!rawReadyFresh) {
+        portEXIT_CRITICAL(&bufferLock);
+        return;
+    }
+    CRGB *frame = rawReady.pixels;
+    rawReady.pixels = leds;
+    const uint32_t begin = rawReady.begin, end = rawReady.end;
+    rawReadyFresh = false;
+    leds = frame;
+    portEXIT_CRITICAL(&bufferLock);
+    // Bytes no chunk carried keep what the strip shows (read-only, like the dirty compare).
+    uint8_t *dst = reinterpret_cast<uint8_t *>(leds);
+    const uint8_t *shown = reinterpret_cast<const uint8_t *>(frontBuffer);
+    memcpy(dst, shown, begin);
+    memcpy(dst + end, shown + end, sizeof(CRGB) * NUM_LEDS - end);
+    setFrameBrightness(BRIGHTNESS_CAP);
+    presentFrame();
 }
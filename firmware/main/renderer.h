@@ -1,5 +1,26 @@
-// renderer.h
 #pragma once
+#include <cstddef>
+#include <cstdint>
 
 void setupLEDs();
-void renderFrame();
+
+// Brightness to transmit with the frame currently being rendered (replaces FastLED.setBrightness in modes).
+void setFrameBrightness(uint8_t brightness);
+
+// Hand the finished back buffer (leds) to the output task and swap in the other buffer.
+// Blocks only while the previous frame is still being transmitted.
+void presentFrame();
+
+// Raw pixel streaming, UDP receive task: copy RGB bytes from a received datagram straight into
+// the spare frame buffer being filled, at `byteOffset` (out-of-range bytes are dropped). The
+// chunks of one frame should be contiguous: pixels before the first or after the last byte
+// they cover keep the value the strip shows when the frame is presented.
+void writeRawPixels(uint32_t byteOffset, const uint8_t *rgb, size_t len);
+
+// UDP receive task, on DDP PUSH: the frame being filled is complete; hand it to the render task
+// by swapping buffer pointers.
+void pushRawPixels();
+
+// Render task: swap the last pushed raw frame in as the back buffer and present it now
+// (MODE_RAW). Does nothing if no frame was pushed since the last call.
+void presentRawFrame();
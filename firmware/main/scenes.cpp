@@ -0,0 +1,153 @@
+// scenes.cpp
+// Scene records, their staging from the control task and the NVS blob codec
+#include "config.h"
+#include "scenes.h"
+#include "protocol.h"
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+// Render task: what the engine shows.
+static SceneRecord records[SCENE_SLOTS];
+static uint8_t recordCount = 0; // 0 = only the built-in default
+static uint8_t activeIndex = 0;
+static const SceneRecord builtIn = defaultScene();
+static unsigned long sceneStartMs = 0;
+static TargetState startGoodScene; // set by sceneStart() from controllerInit()
+static bool persistRequested = false;
+
+// Single-slot handover, like the color LUTs: the control task fills the staged copy and sets
+// stagedReady, the render task copies it over and clears it.
+static SceneRecord stagedRecords[SCENE_SLOTS];
+static uint8_t stagedCount = 0;
+static uint8_t stagedActive = 0;
+static bool stagedPersist = false;
+static std::atomic<bool> stagedReady(false);
+static std::atomic<uint8_t> installedCount(0); // recordCount, readable from the control task
+
+SceneRecord defaultScene() {
+    SceneRecord s;
+    s.effect = SCENE_DEFAULT_EFFECT;
+    s.flags = SCENE_DEFAULT_FLAGS;
+    s.brightness = FALLBACK_BRIGHTNESS;
+    s.speed = SCENE_DEFAULT_SPEED;
+    s.scale = SCENE_DEFAULT_SCALE;
+    s.minutes = SCENE_DEFAULT_MINUTES;
+    s.color1[0] = FALLBACK_R;
+    s.color1[1] = FALLBACK_G;
+    s.color1[2] = FALLBACK_B;
+    s.color2[0] = SCENE_DEFAULT_R2;
+    s.color2[1] = SCENE_DEFAULT_G2;
+    s.color2[2] = SCENE_DEFAULT_B2;
+    return s;
+}
+
+static bool decodeRecords(const uint8_t *buf, uint8_t count, SceneRecord *out) {
+    if (count > SCENE_SLOTS) return false;
+    for (uint8_t k = 0; k < count; ++k) {
+        const uint8_t *r = buf + size_t(k) * SCENE_RECORD_BYTES;
+        if (r[0] >= SCENE_EFFECT_COUNT) return false;
+        SceneRecord &s = out[k];
+        s.effect = r[0];
+        s.flags = r[1];
+        s.brightness = std::min(r[2], static_cast<uint8_t>(BRIGHTNESS_CAP));
+        s.speed = r[3];
+        s.scale = r[4];
+        s.minutes = r[5];
+        memcpy(s.color1, r + 6, 3);
+        memcpy(s.color2, r + 9, 3);
+    }
+    return true;
+}
+
+static void encodeRecord(const SceneRecord &s, uint8_t *r) {
+    r[0] = s.effect;
+    r[1] = s.flags;
+    r[2] = s.brightness;
+    r[3] = s.speed;
+    r[4] = s.scale;
+    r[5] = s.minutes;
+    memcpy(r + 6, s.color1, 3);
+    memcpy(r + 9, s.color2, 3);
+}
+
+bool installScenes(const uint8_t *buf, uint8_t count, uint8_t active) {
+    SceneRecord decoded[SCENE_SLOTS];
+    if (count == 0 || active >= count || !decodeRecords(buf, count, decoded)) return false;
+    memcpy(records, decoded, sizeof(SceneRecord) * count);
+    recordCount = count;
+    activeIndex = active;
+    installedCount.store(count);
+    return true;
+}
+
+uint8_t stageScenes(const uint8_t *buf, uint8_t count, uint8_t active, bool persist) {
+    if (stagedReady.load(std::memory_order_acquire)) return SCENE_STAGE_BUSY;
+    if (active >= (count ? count : installedCount.load())) return SCENE_STAGE_BAD;
+    if (!decodeRecords(buf, count, stagedRecords)) return SCENE_STAGE_BAD;
+    stagedCount = count;
+    stagedActive = active;
+    stagedPersist = persist;
+    stagedReady.store(true, std::memory_order_release);
+    return SCENE_STAGE_OK;
+}
+
+bool commitStagedScenes() {
+    if (!stagedReady.load(std::memory_order_acquire)) return false;
+    if (stagedCount) {
+        memcpy(records, stagedRecords, sizeof(SceneRecord) * stagedCount);
+        recordCount = stagedCount;
+        installedCount.store(stagedCount);
+    }
+    const bool changed = stagedCount != 0 || stagedActive != activeIndex;
+    if (stagedActive < recordCount) activeIndex = stagedActive;
+    persistRequested |= stagedPersist;
+    stagedReady.store(false, std::memory_order_release);
+    return changed;
+}
+
+bool takeScenePersistRequest() {
+    const bool requested = persistRequested;
+    persistRequested = false;
+    return requested;
+}
+
+size_t encodeSceneList(uint8_t *out) {
+    out[0] = SCENE_LIST_VERSION;
+    out[1] = activeIndex;
+    out[2] = recordCount;
+    for (uint8_t k = 0; k < recordCount; ++k) encodeRecord(records[k], out + 3 + size_t(k) * SCENE_RECORD_BYTES);
+    const size_t len = 3 + size_t(recordCount) * SCENE_RECORD_BYTES;
+    const uint16_t crc = crc16(out, len);
+    out[len] = uint8_t(crc & 0xFF);
+    out[len + 1] = uint8_t(crc >> 8);
+    return len + 2;
+}
+
+bool decodeSceneList(const uint8_t *blob, size_t len) {
+    if (len < 5 || blob[0] != SCENE_LIST_VERSION) return false;
+    if (len != 3 + size_t(blob[2]) * SCENE_RECORD_BYTES + 2) return false;
+    if (crc16(blob, len - 2) != uint16_t(blob[len - 2] | (blob[len - 1] << 8))) return false;
+    return installScenes(blob + 3, blob[2], blob[1]);
+}
+
+void sceneStart(unsigned long nowMs) {
+    sceneStartMs = nowMs;
+    startGoodScene = lastGoodScene();
+}
+
+namespace scenes {
+
+const SceneRecord &active() {
+    return recordCount ? records[activeIndex] : builtIn;
+}
+
+unsigned long startMs() {
+    return sceneStartMs;
+}
+
+const TargetState &startScene() {
+    return startGoodScene;
+}
+
+} // namespace scenes
@@ -0,0 +1,156 @@
+// scenes.h
+// On-device scene engine: procedural ambient effects shown while no laptop is sending.
+// Scenes are compact parameter records (uploaded with CONTROL_CMD_SCENES and kept in NVS);
+// the kernels are integer-only and run at SCENE_FRAME_MS.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <FastLED.h>
+#include "config.h"
+#include "state.h"
+
+#define SCENE_BREATHE  0  // color1 * (0.95 + 0.05 * sin(t)), the classic Mode 4 fallback
+#define SCENE_NOISE    1  // slow noise field blending color1 <-> color2 (inoise8)
+#define SCENE_GRADIENT 2  // color1 -> color2 -> color1 gradient travelling along the strip
+#define SCENE_SUNRISE  3  // color1 -> color2 and dark -> brightness over `minutes`, then holds
+#define SCENE_EFFECT_COUNT 4
+
+#define SCENE_FLAG_LAST_COLOR 0x01 // color1 and brightness come from the last good scene (at sceneStart)
+
+// Wire/NVS record (SCENE_RECORD_BYTES):
+//   0 effect | 1 flags | 2 brightness | 3 speed | 4 scale | 5 minutes | 6-8 color1 | 9-11 color2
+// speed: time step in 1/16 per ms (phase, noise time and gradient travel all derive from it).
+// scale: spatial step (noise: x2 per LED in 1/256 cells; gradient: x8 per LED in 1/65536 cycles).
+#define SCENE_RECORD_BYTES 12
+
+struct SceneRecord {
+    uint8_t effect;
+    uint8_t flags;
+    uint8_t brightness;
+    uint8_t speed;
+    uint8_t scale;
+    uint8_t minutes;
+    uint8_t color1[3];
+    uint8_t color2[3];
+};
+
+// Built-in scene used until records are uploaded (SCENE_DEFAULT_* in config.h).
+SceneRecord defaultScene();
+
+// Decode and install `count` records from `buf` (SCENE_RECORD_BYTES each) and make `active`
+// the shown one. Returns false (nothing changed) if a record does not validate or `active`
+// is out of range. Setup only; at runtime use stageScenes().
+bool installScenes(const uint8_t *buf, uint8_t count, uint8_t active);
+
+// Any task: hand new records (count > 0) or just a new active index (count == 0) to the
+// render task; `persist` also stores the result in NVS. Returns SCENE_STAGE_OK,
+// SCENE_STAGE_BAD or SCENE_STAGE_BUSY (previous request not taken over yet).
+#define SCENE_STAGE_OK   0
+#define SCENE_STAGE_BAD  1
+#define SCENE_STAGE_BUSY 2
+uint8_t stageScenes(const uint8_t *buf, uint8_t count, uint8_t active, bool persist);
+
+// Render task: adopt staged records; returns true if the shown scene changed.
+bool commitStagedScenes();
+
+// Render task: true once after a committed request asked to persist (persistence.cpp).
+bool takeScenePersistRequest();
+
+// Encode the installed records as the NVS blob (persistence.cpp): returns its length.
+//   0 version | 1 active | 2 count | count x record | crc16 over all prior bytes
+#define SCENE_LIST_VERSION 1
+#define SCENE_LIST_MAX_BYTES (3 + SCENE_SLOTS * SCENE_RECORD_BYTES + 2)
+size_t encodeSceneList(uint8_t *out);
+bool decodeSceneList(const uint8_t *blob, size_t len);
+
+// Render task: the scene clock (sunrise progress) starts now, and the last good scene's color
+// is latched for SCENE_FLAG_LAST_COLOR (packets arriving later must not change the outgoing
+// look while the laptop's cross-fade runs).
+void sceneStart(unsigned long nowMs);
+
+// Render the active scene at `nowMs` into `out` through `op` (fx::StoreOp/BlendOp/metered)
+// and return the frame brightness.
+template <class Op> uint8_t renderScene(unsigned long nowMs, CRGB *out, Op op);
+
+// ---- implementation ----
+namespace scenes {
+
+const SceneRecord &active();
+unsigned long startMs();
+const TargetState &startScene(); // lastGoodScene() at sceneStart
+
+// Colors and brightness after SCENE_FLAG_LAST_COLOR.
+inline CRGB color1(const SceneRecord &s) {
+    if (s.flags & SCENE_FLAG_LAST_COLOR) return CRGB(startScene().r, startScene().g, startScene().b);
+    return CRGB(s.color1[0], s.color1[1], s.color1[2]);
+}
+inline CRGB color2(const SceneRecord &s) {
+    return CRGB(s.color2[0], s.color2[1], s.color2[2]);
+}
+inline uint8_t brightness(const SceneRecord &s) {
+#if FORCE_MAX_BRIGHTNESS
+    (void)s;
+    return 255;
+#else
+    return (s.flags & SCENE_FLAG_LAST_COLOR) ? startScene().brightness : s.brightness;
+#endif
+}
+
+// Scene time in 1/16 ms x speed. 64-bit: hours of uptime times the speed overflow 32 bits.
+inline uint32_t sceneTime(const SceneRecord &s, unsigned long nowMs) {
+    return uint32_t((uint64_t(nowMs) * s.speed) >> 4);
+}
+
+// 0 -> 255 -> 0 over one 16-bit cycle.
+inline uint8_t triwave16(uint16_t pos) {
+    return uint8_t(pos & 0x8000 ? (0xFFFF - pos) >> 7 : pos >> 7);
+}
+
+template <class Op> uint8_t breathe(const SceneRecord &s, unsigned long nowMs, CRGB *out, Op op) {
+    // 243/256 + 13/256 * sin: never above 1.0, so no clamps.
+    const int32_t factor = 243 + ((int32_t(sin16(uint16_t(sceneTime(s, nowMs)))) * 13) >> 15);
+    const CRGB c = color1(s);
+    const CRGB px(uint8_t((c.r * factor) >> 8), uint8_t((c.g * factor) >> 8), uint8_t((c.b * factor) >> 8));
+    for (int i = 0; i < NUM_LEDS; ++i) op(out[i], px);
+    return brightness(s);
+}
+
+template <class Op> uint8_t noise(const SceneRecord &s, unsigned long nowMs, CRGB *out, Op op) {
+    const CRGB a = color1(s), b = color2(s);
+    const uint16_t y = uint16_t(sceneTime(s, nowMs) >> 4);
+    const uint16_t step = uint16_t(s.scale) * 2;
+    uint16_t x = 0;
+    for (int i = 0; i < NUM_LEDS; ++i, x = uint16_t(x + step)) op(out[i], blend(a, b, inoise8(x, y)));
+    return brightness(s);
+}
+
+template <class Op> uint8_t gradient(const SceneRecord &s, unsigned long nowMs, CRGB *out, Op op) {
+    const CRGB a = color1(s), b = color2(s);
+    const uint16_t step = uint16_t(s.scale) * 8;
+    uint16_t pos = uint16_t(sceneTime(s, nowMs));
+    for (int i = 0; i < NUM_LEDS; ++i, pos = uint16_t(pos + step)) op(out[i], blend(a, b, triwave16(pos)));
+    return brightness(s);
+}
+
+template <class Op> uint8_t sunrise(const SceneRecord &s, unsigned long nowMs, CRGB *out, Op op) {
+    const uint32_t durationMs = uint32_t(s.minutes ? s.minutes : 1) * 60000UL;
+    const uint32_t elapsed = uint32_t(nowMs - startMs());
+    const uint8_t p = elapsed >= durationMs ? 255 : uint8_t((uint64_t(elapsed) * 255) / durationMs);
+    const CRGB px = blend(color1(s), color2(s), p);
+    for (int i = 0; i < NUM_LEDS; ++i) op(out[i], px);
+    // Quadratic brightness ramp: the first minutes stay a dim glow, the way dawn does.
+    return scale8(brightness(s), scale8(p, p));
+}
+
+} // namespace scenes
+
+template <class Op> uint8_t renderScene(unsigned long nowMs, CRGB *out, Op op) {
+    const SceneRecord &s = scenes::active();
+    switch (s.effect) {
+        case SCENE_NOISE: return scenes::noise(s, nowMs, out, op);
+        case SCENE_GRADIENT: return scenes::gradient(s, nowMs, out, op);
+        case SCENE_SUNRISE: return scenes::sunrise(s, nowMs, out, op);
+        case SCENE_BREATHE:
+        default: return scenes::breathe(s, nowMs, out, op);
+    }
+}
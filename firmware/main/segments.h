@@ -0,0 +1,39 @@
+// segments.h
+// Physical strip segments laid over the logical leds[] buffer
+#pragma once
+#include "config.h"
+#include <cstdint>
+
+#if SEGMENT_COUNT < 1 || SEGMENT_COUNT > 4
+#error "SEGMENT_COUNT must be 1..4"
+#endif
+
+struct Segment {
+    uint16_t offset;
+    uint16_t count;
+};
+
+static const Segment kSegments[SEGMENT_COUNT] = {
+    {0, SEGMENT0_LEDS},
+#if SEGMENT_COUNT > 1
+    {SEGMENT0_LEDS, SEGMENT1_LEDS},
+#endif
+#if SEGMENT_COUNT > 2
+    {SEGMENT0_LEDS + SEGMENT1_LEDS, SEGMENT2_LEDS},
+#endif
+#if SEGMENT_COUNT > 3
+    {SEGMENT0_LEDS + SEGMENT1_LEDS + SEGMENT2_LEDS, SEGMENT3_LEDS},
+#endif
+};
+
+static_assert(SEGMENT0_LEDS
+#if SEGMENT_COUNT > 1
+              + SEGMENT1_LEDS
+#endif
+#if SEGMENT_COUNT > 2
+              + SEGMENT2_LEDS
+#endif
+#if SEGMENT_COUNT > 3
+              + SEGMENT3_LEDS
+#endif
+              == NUM_LEDS, "segment LED counts must add up to NUM_LEDS");
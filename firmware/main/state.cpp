@@ -3,6 +3,8 @@
 #include "config.h"
 #include "state.h"
 #include <algorithm>
+#include <math.h>
+#include <string.h>
 
 // Global state definitions
 TargetState targetState = {};
@@ -10,29 +12,71 @@ RenderState renderState = {};
 
 // Packet sequencing and timing
 static bool haveFrame = false;
-static uint8_t lastFrameId = 0;
+static uint16_t lastSeq = 0;
+static uint8_t lastVersion = 0;
 static unsigned long lastFrameMs = 0;
+static uint32_t lastSenderMs = 0;
+
+// v2 keyframe interpolation (render color/brightness eased over one sender interval)
+static RenderColor interpFromColor = {};
+static float interpFromBrightness = 0.0f;
+static uint8_t interpFromZones[MAX_ZONES][3];
+static unsigned long interpStartMs = 0;
+static unsigned long interpDurationMs = 0; // 0 = no interpolation in progress
+
+// Beat envelope (v2 beat extension)
+static bool haveBeatId = false;
+static uint8_t lastBeatId = 0;
+static bool beatActive = false;
+static unsigned long beatStartMs = 0;
+static float beatFrom = 0.0f; // envelope level when the beat started (attack rises from here)
+static float beatPeak = 0.0f;
 
 // Direction hysteresis
 static uint8_t stableDirection = 128;
 static uint8_t dirStableCount = 0;
 
-void initState() {
+static void copyTargetZones() {
+    renderState.zone_count = targetState.zone_count;
+    memcpy(renderState.zones, targetState.zones, size_t(targetState.zone_count) * 3);
+}
+
+static TargetState goodScene = {
+    uint8_t(FALLBACK_MODE), uint8_t(FALLBACK_R), uint8_t(FALLBACK_G), uint8_t(FALLBACK_B),
+    uint8_t(FALLBACK_BRIGHTNESS), 0, 0, 128, 0, {}};
+
+const TargetState &lastGoodScene() {
+    return goodScene;
+}
+
+void setLastGoodScene(const TargetState &scene) {
+    goodScene = scene;
+}
+
+void applyFallbackScene() {
+#if ENABLE_SCENE_ENGINE
+    targetState.mode = static_cast<uint8_t>(MODE_SCENE);
+#else
     targetState.mode = static_cast<uint8_t>(FALLBACK_MODE);
-    targetState.r = static_cast<uint8_t>(FALLBACK_R);
-    targetState.g = static_cast<uint8_t>(FALLBACK_G);
-    targetState.b = static_cast<uint8_t>(FALLBACK_B);
-    targetState.brightness = static_cast<uint8_t>(FALLBACK_BRIGHTNESS);
+#endif
+    targetState.r = goodScene.r;
+    targetState.g = goodScene.g;
+    targetState.b = goodScene.b;
+    targetState.brightness = goodScene.brightness;
+#if FORCE_MAX_BRIGHTNESS
+    targetState.brightness = 255;
+#endif
     targetState.motion_energy = 0;
     targetState.motion_speed = 0;
     targetState.motion_direction = 128;
+    targetState.zone_count = 0;
+    beatActive = false;
+    renderState.render_beat = 0.0f;
+}
 
-    renderState.render_color.r = float(FALLBACK_R);
-    renderState.render_color.g = float(FALLBACK_G);
-    renderState.render_color.b = float(FALLBACK_B);
-    renderState.render_brightness = float(FALLBACK_BRIGHTNESS);
-    renderState.render_motion_energy = 0;
-    renderState.render_phase = 0;
+void initState() {
+    applyFallbackScene();
+    snapRenderStateToTarget(true);
 }
 
 void updateStateFromPacket(const Packet &packet, unsigned long nowMs) {
@@ -50,28 +94,35 @@ void updateStateFromPacket(const Packet &packet, unsigned long nowMs) {
         dirStableCount = 0;
     }
 
-    // Frame sequencing and phase timing
+    // Frame sequencing and phase timing. v2 carries a 16-bit seq and the sender's clock,
+    // so gaps and intervals come from the sender rather than from arrival jitter.
+    const bool timestamped = packet.version >= 2 && lastVersion >= 2;
     bool resetPhase = false;
     bool skipPhaseAdvance = false;
-    uint8_t prevFrame = lastFrameId;
     if (haveFrame) {
-        uint8_t expected = uint8_t(prevFrame + 1);
-        if (packet.frame_id != expected) {
+        const uint16_t seqMask = timestamped ? 0xFFFF : 0xFF;
+        uint16_t gap = uint16_t(packet.seq - lastSeq) & seqMask;
+        if (gap != 1) {
             resetPhase = true;
-            uint8_t gap = static_cast<uint8_t>(packet.frame_id - prevFrame);
             if (gap > 5) {
                 skipPhaseAdvance = true; // large gap: don't advance on stale timing
             }
         }
     }
 
-    unsigned long dt_ms = haveFrame ? (nowMs - lastFrameMs) : 40UL;
+    unsigned long dt_ms = 40UL;
+    if (haveFrame) {
+        dt_ms = timestamped ? (unsigned long)(packet.sender_ms - lastSenderMs) : (nowMs - lastFrameMs);
+    }
     if (dt_ms < 5UL) dt_ms = 5UL;
-    if (dt_ms > 120UL) { resetPhase = true; dt_ms = 0UL; }
+    if (dt_ms > PACKET_MAX_INTERVAL_MS) { resetPhase = true; dt_ms = 0UL; }
     if (skipPhaseAdvance) dt_ms = 0UL;
 
-    lastFrameId = packet.frame_id;
+    const uint8_t prevMode = targetState.mode;
+    lastSeq = packet.seq;
+    lastVersion = packet.version;
     lastFrameMs = nowMs;
+    lastSenderMs = packet.sender_ms;
     haveFrame = true;
 
     // Apply target with clamping
@@ -95,15 +146,44 @@ void updateStateFromPacket(const Packet &packet, unsigned long nowMs) {
     targetState.motion_speed = std::min(packet.motion_speed, static_cast<uint8_t>(MOTION_SPEED_CAP));
     targetState.motion_direction = stableDirection;
 
+    targetState.zone_count = packet.zone_count;
+    for (uint8_t z = 0; z < packet.zone_count; ++z) {
+        targetState.zones[z][0] = std::min(packet.zones[z][0], static_cast<uint8_t>(MAX_R));
+        targetState.zones[z][1] = std::min(packet.zones[z][1], static_cast<uint8_t>(MAX_G));
+        targetState.zones[z][2] = std::min(packet.zones[z][2], static_cast<uint8_t>(MAX_B));
+    }
+
 #if FORCE_MAX_BRIGHTNESS
     if (targetState.mode == FALLBACK_MODE) {
         targetState.brightness = 255;
     }
 #endif
 
-    // Direct copy for color/brightness to remove double smoothing
-    renderState.render_color = {float(targetState.r), float(targetState.g), float(targetState.b)};
-    renderState.render_brightness = float(targetState.brightness);
+#if FALLBACK_USE_LAST_SCENE
+    // Mode 5 (off) and dark frames are not worth falling back to.
+    if (targetState.mode >= 1 && targetState.mode <= 4 && targetState.brightness > 0) {
+        goodScene = targetState;
+    }
+#endif
+
+#if ENABLE_KEYFRAME_INTERPOLATION
+    if (timestamped && dt_ms > 0 && targetState.mode == prevMode &&
+        targetState.zone_count == renderState.zone_count) {
+        // Ease from whatever is on screen now to the new keyframe over one sender interval.
+        interpFromColor = renderState.render_color;
+        interpFromBrightness = renderState.render_brightness;
+        memcpy(interpFromZones, renderState.zones, size_t(renderState.zone_count) * 3);
+        interpStartMs = nowMs;
+        interpDurationMs = dt_ms < KEYFRAME_INTERP_MAX_MS ? dt_ms : KEYFRAME_INTERP_MAX_MS;
+    } else
+#endif
+    {
+        // Direct copy for color/brightness to remove double smoothing
+        renderState.render_color = {float(targetState.r), float(targetState.g), float(targetState.b)};
+        renderState.render_brightness = float(targetState.brightness);
+        copyTargetZones();
+        interpDurationMs = 0;
+    }
 
     // Minimal motion smoothing (<=10 ms effective)
     float motion_alpha = std::min(1.0f, (dt_ms / 10.0f));
@@ -112,6 +192,20 @@ void updateStateFromPacket(const Packet &packet, unsigned long nowMs) {
         renderState.render_motion_energy = 1.0f;
     }
 
+#if ENABLE_BEAT_ENVELOPE
+    // Every packet repeats the latest beat for a while; only a new id starts the envelope.
+    if (packet.beat_strength) {
+        if ((!haveBeatId || packet.beat_id != lastBeatId) && packet.beat_age_ms <= BEAT_MAX_AGE_MS) {
+            beatFrom = renderState.render_beat;
+            beatPeak = packet.beat_strength / 255.0f;
+            beatStartMs = nowMs - packet.beat_age_ms;
+            beatActive = true;
+        }
+        lastBeatId = packet.beat_id;
+        haveBeatId = true;
+    }
+#endif
+
     // Phase is advanced in the main render loop (packet-time driven).
     if (resetPhase) {
         renderState.render_phase = 0.0f;
@@ -119,9 +213,11 @@ void updateStateFromPacket(const Packet &packet, unsigned long nowMs) {
 }
 
 void snapRenderStateToTarget(bool resetPhase) {
+    interpDurationMs = 0;
     renderState.render_color = {float(targetState.r), float(targetState.g), float(targetState.b)};
     renderState.render_brightness = float(targetState.brightness);
     renderState.render_motion_energy = float(targetState.motion_energy);
+    copyTargetZones();
     if (resetPhase) {
         renderState.render_phase = 0.0f;
     }
@@ -149,6 +245,44 @@ void advanceRenderPhase(float dt_s, float packet_dt_s) {
     renderState.render_phase += step;
 }
 
+void interpolateRenderState(unsigned long nowMs) {
+    if (interpDurationMs == 0) return;
+    unsigned long elapsed = nowMs - interpStartMs;
+    float a = 1.0f;
+    if (elapsed < interpDurationMs) {
+        a = float(elapsed) / float(interpDurationMs);
+    }
+    renderState.render_color.r = interpFromColor.r + a * (float(targetState.r) - interpFromColor.r);
+    renderState.render_color.g = interpFromColor.g + a * (float(targetState.g) - interpFromColor.g);
+    renderState.render_color.b = interpFromColor.b + a * (float(targetState.b) - interpFromColor.b);
+    renderState.render_brightness = interpFromBrightness + a * (float(targetState.brightness) - interpFromBrightness);
+    const int a8 = int(a * 256.0f);
+    for (uint8_t z = 0; z < renderState.zone_count; ++z) {
+        for (int c = 0; c < 3; ++c) {
+            int from = interpFromZones[z][c];
+            renderState.zones[z][c] = uint8_t(from + (((int(targetState.zones[z][c]) - from) * a8) >> 8));
+        }
+    }
+    if (a >= 1.0f) interpDurationMs = 0;
+}
+
+void updateBeatEnvelope(unsigned long nowMs) {
+    if (!beatActive) {
+        renderState.render_beat = 0.0f;
+        return;
+    }
+    const long t = long(nowMs - beatStartMs);
+    if (t < 0) return; // played out ahead of the onset (jitter buffer); keep the current level
+    if (t < BEAT_ATTACK_MS) {
+        renderState.render_beat = beatFrom + (beatPeak - beatFrom) * (float(t) / float(BEAT_ATTACK_MS));
+    } else if (t < BEAT_ATTACK_MS + 6L * BEAT_DECAY_MS) {
+        renderState.render_beat = beatPeak * expf(-float(t - BEAT_ATTACK_MS) / float(BEAT_DECAY_MS));
+    } else {
+        renderState.render_beat = 0.0f;
+        beatActive = false;
+    }
+}
+
 void smoothState(float /*dt*/) {
     // Smoothing removed for color/brightness; motion handled in updateStateFromPacket.
 }
@@ -4,6 +4,7 @@
 #ifndef STATE_H
 #define STATE_H
 #include <cstdint>
+#include "config.h"
 
 struct Packet {
     uint8_t mode;
@@ -12,7 +13,17 @@ struct Packet {
     uint8_t motion_energy;
     uint8_t motion_speed;
     uint8_t motion_direction;
-    uint8_t frame_id;
+    uint8_t frame_id;     // low byte of seq (v1: the only sequence field)
+    uint8_t version;      // 1 = legacy 12-byte packet, 2 = timestamped v2
+    uint8_t flags;        // v2 extension flags
+    uint16_t seq;         // v2: 16-bit sequence; v1: frame_id
+    uint32_t sender_ms;   // v2: sender clock at build time; v1: 0
+    uint8_t zone_count;   // v2 zone extension: 0 = single global color
+    uint8_t zones[MAX_ZONES][3];
+    uint8_t sync_delay_ms; // v2 sync extension: present at sender_ms + this; 0 = adaptive playout
+    uint8_t beat_id;       // v2 beat extension: counts up per onset (repeats until the next one)
+    uint8_t beat_strength; // 0 = no beat in this packet
+    uint8_t beat_age_ms;   // onset time = sender_ms - this
 };
 
 struct TargetState {
@@ -22,6 +33,8 @@ struct TargetState {
     uint8_t motion_energy;
     uint8_t motion_speed;
     uint8_t motion_direction;
+    uint8_t zone_count;
+    uint8_t zones[MAX_ZONES][3];
 };
 
 struct RenderColor {
@@ -33,16 +46,36 @@ struct RenderState {
     float render_brightness;
     float render_motion_energy;
     float render_phase;
+    float render_beat; // beat envelope, 0-1 (strength x attack/decay)
+    uint8_t zone_count;
+    uint8_t zones[MAX_ZONES][3];
 };
 
 extern TargetState targetState;
 extern RenderState renderState;
 
+// Point the target at the fallback scene and snap the render state to it.
 void initState();
 void updateStateFromPacket(const Packet &packet, unsigned long nowMs);
 void smoothState(float dt);
 
+// Last good scene: the latest packet scene in Modes 1-4 with FALLBACK_USE_LAST_SCENE (or one
+// restored from NVS), else the FALLBACK_R/G/B/BRIGHTNESS defaults.
+const TargetState &lastGoodScene();
+void setLastGoodScene(const TargetState &scene);
+// Target = last good scene's color and brightness without motion or zones, in MODE_SCENE
+// (scene engine, scenes.h) or FALLBACK_MODE without it.
+void applyFallbackScene();
+
 // Packet-time driven animation helpers
 void snapRenderStateToTarget(bool resetPhase);
 void advanceRenderPhase(float dt_s, float packet_dt_s);
+
+// v2 keyframe interpolation: eases render color/brightness toward the latest target
+// over the sender-side packet interval. Call once per render frame.
+void interpolateRenderState(unsigned long nowMs);
+
+// Beat envelope: packets with a new beat id restart it at the beat's own time; this sets
+// renderState.render_beat for `nowMs`. Call once per render frame.
+void updateBeatEnvelope(unsigned long nowMs);
 #endif // STATE_H
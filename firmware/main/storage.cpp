@@ -1,19 +1,99 @@
 // storage.cpp
-// Persistent storage for last mode
+// Persistent storage for the last good scene, Wi-Fi association cache, color calibration and
+// scene engine records
 #include "config.h"
+#include "storage.h"
+#include "color_lut.h"
 #include <Preferences.h>
+#include <string.h>
 
-Preferences prefs;
+// The functions below may run in the persistence and Wi-Fi tasks at the same time, so each
+// opens its own NVS handle.
+void saveSceneBlob(const uint8_t *blob, size_t len) {
+    Preferences nvs;
+    nvs.begin("ambient", false);
+    nvs.putBytes("scene", blob, len);
+    nvs.end();
+}
+
+size_t loadSceneBlob(uint8_t *blob, size_t capacity) {
+    Preferences nvs;
+    nvs.begin("ambient", true);
+    size_t len = nvs.isKey("scene") ? nvs.getBytesLength("scene") : 0;
+    if (len > capacity || nvs.getBytes("scene", blob, len) != len) len = 0;
+    nvs.end();
+    return len;
+}
+
+void saveWifiCache(const WifiCache &cache) {
+    Preferences nvs;
+    nvs.begin("ambient", false);
+    nvs.putBytes("wifi", &cache, sizeof(cache));
+    nvs.end();
+}
+
+bool loadWifiCache(WifiCache &cache) {
+    Preferences nvs;
+    nvs.begin("ambient", true);
+    bool ok = nvs.isKey("wifi") && nvs.getBytesLength("wifi") == sizeof(cache) &&
+              nvs.getBytes("wifi", &cache, sizeof(cache)) == sizeof(cache);
+    nvs.end();
+    return ok;
+}
+
+void clearWifiCache() {
+    Preferences nvs;
+    nvs.begin("ambient", false);
+    nvs.remove("wifi");
+    nvs.end();
+}
+
+static void colorLutKey(uint8_t segment, char *key) {
+    memcpy(key, "lut0", 5);
+    key[3] = char('0' + segment);
+}
+
+void saveColorLut(uint8_t segment, const uint8_t *table) {
+    char key[5];
+    colorLutKey(segment, key);
+    Preferences nvs;
+    nvs.begin("ambient", false);
+    nvs.putBytes(key, table, COLOR_LUT_BYTES);
+    nvs.end();
+}
+
+bool loadColorLut(uint8_t segment, uint8_t *table) {
+    char key[5];
+    colorLutKey(segment, key);
+    Preferences nvs;
+    nvs.begin("ambient", true);
+    bool ok = nvs.isKey(key) && nvs.getBytesLength(key) == COLOR_LUT_BYTES &&
+              nvs.getBytes(key, table, COLOR_LUT_BYTES) == COLOR_LUT_BYTES;
+    nvs.end();
+    return ok;
+}
+
+void clearColorLut(uint8_t segment) {
+    char key[5];
+    colorLutKey(segment, key);
+    Preferences nvs;
+    nvs.begin("ambient", false);
+    nvs.remove(key);
+    nvs.end();
+}
 
-void saveLastState(uint8_t mode) {
-    prefs.begin("ambient", false);
-    prefs.putUChar("last_mode", mode);
-    prefs.end();
+void saveSceneList(const uint8_t *blob, size_t len) {
+    Preferences nvs;
+    nvs.begin("ambient", false);
+    nvs.putBytes("scenes", blob, len);
+    nvs.end();
 }
 
-uint8_t loadLastState() {
-    prefs.begin("ambient", true);
-    uint8_t mode = prefs.getUChar("last_mode", 4);
-    prefs.end();
-    return mode;
+size_t loadSceneList(uint8_t *blob, size_t capacity) {
+    Preferences nvs;
+    nvs.begin("ambient", true);
+    size_t len = nvs.isKey("scenes") ? nvs.getBytesLength("scenes") : 0;
+    if (len > capacity || nvs.getBytes("scenes", blob, len) != len) len = 0;
+    nvs.end();
+    return len;
 }
@@ -1,9 +1,35 @@
 // storage.h
 #ifndef STORAGE_H
 #define STORAGE_H
+#include <cstddef>
 #include <cstdint>
 
-void saveLastState(uint8_t mode);
-uint8_t loadLastState();
+// Versioned last-good-scene blob (layout in persistence.cpp), at most SCENE_BLOB_MAX bytes.
+#define SCENE_BLOB_MAX 112
+void saveSceneBlob(const uint8_t *blob, size_t len);
+size_t loadSceneBlob(uint8_t *blob, size_t capacity); // 0 if none stored or too large
+
+// Last successful Wi-Fi association, for fast reconnects (wifi_link.cpp). IPv4 addresses are
+// in lwIP byte order (IPAddress's uint32_t). `ssidHash` ties the cache to WIFI_SSID.
+struct WifiCache {
+    uint32_t ssidHash;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip, gateway, subnet, dns;
+};
+
+void saveWifiCache(const WifiCache &cache);
+bool loadWifiCache(WifiCache &cache); // false if none stored
+void clearWifiCache();
+
+// Color LUT for one strip segment (COLOR_LUT_BYTES, see color_lut.h).
+void saveColorLut(uint8_t segment, const uint8_t *table);
+bool loadColorLut(uint8_t segment, uint8_t *table); // false if none stored
+void clearColorLut(uint8_t segment);
+
+// Scene engine records (layout in scenes.h), at most SCENE_LIST_MAX_BYTES.
+void saveSceneList(const uint8_t *blob, size_t len);
+size_t loadSceneList(uint8_t *blob, size_t capacity); // 0 if none stored or too large
 
 #endif // STORAGE_H
@@ -0,0 +1,147 @@
+// telemetry.cpp
+// Stage timings are kept as log-linear microsecond histograms (exact below 8 µs, then four
+// buckets per octave up to ~1 s), so p99 costs no per-sample storage.
+#include "config.h"
+#include "telemetry.h"
+
+#if ENABLE_TELEMETRY
+#include <Arduino.h>
+#include <atomic>
+#include "protocol.h"
+
+#define HIST_BUCKETS 80
+
+struct Histogram {
+    uint32_t buckets[HIST_BUCKETS];
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    std::atomic<bool> resetPending;
+};
+
+static std::atomic<uint32_t> counters[COUNTER_COUNT];
+static Histogram histograms[TIMING_COUNT];
+
+static bool haveSeq = false;
+static uint8_t lastSeqVersion = 0;
+static uint16_t lastSeq = 0;
+
+static inline uint8_t log2u(uint32_t v) {
+    return uint8_t(31 - __builtin_clz(v));
+}
+
+static inline uint8_t bucketFor(uint32_t us) {
+    if (us < 8) return uint8_t(us);
+    uint8_t octave = log2u(us);
+    uint32_t idx = 8u + (octave - 3u) * 4u + ((us >> (octave - 2)) & 3u);
+    return idx < HIST_BUCKETS ? uint8_t(idx) : uint8_t(HIST_BUCKETS - 1);
+}
+
+static inline uint32_t bucketLowerUs(uint32_t idx) {
+    if (idx < 8) return idx;
+    uint32_t octave = 3 + (idx - 8) / 4;
+    return (4u + (idx - 8) % 4) << (octave - 2);
+}
+
+static void clearHistogram(Histogram &h) {
+    for (int i = 0; i < HIST_BUCKETS; ++i) h.buckets[i] = 0;
+    h.count = 0;
+    h.minUs = UINT32_MAX;
+    h.maxUs = 0;
+    h.sumUs = 0;
+}
+
+void telemetryCount(TelemetryCounter counter, uint32_t n) {
+    counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void telemetryRecord(TelemetryTiming timing, uint32_t startUs) {
+    uint32_t us = telemetryMicros() - startUs;
+
+    Histogram &h = histograms[timing];
+    // The writer applies resets itself so the reader never races it on the buckets.
+    if (h.resetPending.exchange(false, std::memory_order_acquire) || h.count == 0) clearHistogram(h);
+    h.buckets[bucketFor(us)]++;
+    h.count++;
+    h.sumUs += us;
+    if (us < h.minUs) h.minUs = us;
+    if (us > h.maxUs) h.maxUs = us;
+}
+
+void telemetryNoteSequence(uint8_t version, uint16_t seq) {
+    const uint16_t mask = version >= 2 ? 0xFFFF : 0xFF;
+    if (!haveSeq || version != lastSeqVersion) {
+        haveSeq = true;
+        lastSeqVersion = version;
+        lastSeq = seq;
+        return;
+    }
+    uint16_t ahead = uint16_t(seq - lastSeq) & mask;
+    if (ahead == 0) {
+        telemetryCount(COUNTER_DUPLICATE);
+        return;
+    }
+    if (ahead > mask / 2) {
+        // Older than the newest seen: it was counted lost when the newer one arrived.
+        telemetryCount(COUNTER_REORDERED);
+        if (counters[COUNTER_LOST].load(std::memory_order_relaxed) > 0) {
+            counters[COUNTER_LOST].fetch_sub(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    if (ahead > 1) telemetryCount(COUNTER_LOST, ahead - 1u);
+    lastSeq = seq;
+}
+
+static inline uint8_t *putU32(uint8_t *p, uint32_t v) {
+    p[0] = uint8_t(v);
+    p[1] = uint8_t(v >> 8);
+    p[2] = uint8_t(v >> 16);
+    p[3] = uint8_t(v >> 24);
+    return p + 4;
+}
+
+static uint32_t percentileUs(const Histogram &h, uint32_t count, uint32_t permille) {
+    uint64_t rank = (uint64_t(count) * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h.buckets[i];
+        if (seen >= rank) {
+            // Report the bucket's upper edge, clamped to the observed maximum.
+            uint32_t upper = i + 1 < HIST_BUCKETS ? bucketLowerUs(i + 1) - 1 : h.maxUs;
+            return upper < h.maxUs ? upper : h.maxUs;
+        }
+    }
+    return h.maxUs;
+}
+
+size_t telemetryBuildReply(uint8_t cmd, bool reset, uint8_t *out, size_t cap) {
+    if (cap < TELEMETRY_REPLY_SIZE) return 0;
+    uint8_t *p = out;
+    *p++ = CONTROL_MAGIC;
+    *p++ = uint8_t(cmd | CONTROL_REPLY);
+    *p++ = TELEMETRY_VERSION;
+    *p++ = COUNTER_COUNT;
+    *p++ = TIMING_COUNT;
+    p = putU32(p, millis());
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        p = putU32(p, reset ? counters[i].exchange(0, std::memory_order_relaxed)
+                            : counters[i].load(std::memory_order_relaxed));
+    }
+    for (int t = 0; t < TIMING_COUNT; ++t) {
+        const Histogram &h = histograms[t];
+        uint32_t count = h.resetPending.load(std::memory_order_relaxed) ? 0 : h.count;
+        p = putU32(p, count);
+        p = putU32(p, count ? h.minUs : 0);
+        p = putU32(p, count ? uint32_t(h.sumUs / count) : 0);
+        p = putU32(p, count ? h.maxUs : 0);
+        p = putU32(p, count ? percentileUs(h, count, 990) : 0);
+        if (reset) histograms[t].resetPending.store(true, std::memory_order_release);
+    }
+    uint16_t crc = crc16(out, size_t(p - out));
+    *p++ = uint8_t(crc);
+    *p++ = uint8_t(crc >> 8);
+    return size_t(p - out);
+}
+#endif
@@ -0,0 +1,67 @@
+// telemetry.h
+// On-device performance counters and stage timing histograms
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+
+enum TelemetryCounter {
+    COUNTER_PACKETS_OK = 0,   // valid v1/v2 datagrams
+    COUNTER_BAD_FORMAT,       // wrong size/magic/version or malformed extension
+    COUNTER_BAD_CHECKSUM,     // v1 XOR or v2 CRC16 mismatch
+    COUNTER_LOST,             // seq/frame_id numbers never received
+    COUNTER_REORDERED,        // arrived after a later seq
+    COUNTER_DUPLICATE,        // same seq twice in a row
+    COUNTER_QUEUE_OVERFLOW,   // dropped because the render task fell behind
+    COUNTER_CONCEALED,        // losses filled in by the jitter buffer
+    COUNTER_LATE_DROPPED,     // arrived after its playout point
+    COUNTER_FRAMES_RENDERED,
+    COUNTER_FRAMES_SKIPPED,   // dirty-frame skip: identical to the strip
+    COUNTER_RAW_FRAMES,
+    COUNTER_POWER_LIMITED,    // frames sent with at least one segment scaled down for current
+    COUNTER_WIFI_RECONNECTS,  // station link lost after being up
+    COUNTER_COUNT
+};
+
+enum TelemetryTiming {
+    TIMING_PARSE = 0,   // parsePacket() in the UDP receive task
+    TIMING_STATE,       // updateStateFromPacket()
+    TIMING_KERNEL,      // mode kernel for one frame
+    TIMING_SHOW,        // color LUT + FastLED.show() in the output task
+    TIMING_COUNT
+};
+
+// Stats reply: 0 A6 | 1 cmd|0x80 | 2 TELEMETRY_VERSION | 3 counter count C | 4 timing count T
+//   5-8 uptime ms | C x u32 counter | T x {count, min, avg, max, p99} u32 (µs) | crc16
+// All multi-byte fields little-endian.
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_REPLY_SIZE (9 + COUNTER_COUNT * 4 + TIMING_COUNT * 20 + 2)
+
+#if ENABLE_TELEMETRY
+#include "esp_timer.h"
+
+// Microsecond timestamp for telemetryRecord(). The shared esp_timer counter is the same on
+// both cores, unlike CCOUNT, so a stage may start and end on different cores (the AsyncUDP
+// receive task is not pinned).
+static inline uint32_t telemetryMicros() {
+    return uint32_t(esp_timer_get_time());
+}
+
+// Counters are atomic and may be bumped from any task. Each timing histogram has a single
+// writer task (see TelemetryTiming); the reply is a best-effort snapshot.
+void telemetryCount(TelemetryCounter counter, uint32_t n = 1);
+void telemetryRecord(TelemetryTiming timing, uint32_t startUs);
+
+// Sequence accounting for loss/reorder/duplicate counters (UDP receive task only).
+void telemetryNoteSequence(uint8_t version, uint16_t seq);
+
+// Fill `out` with a stats reply; returns its length (0 if cap is too small). With `reset`,
+// every counter and histogram starts over after the snapshot.
+size_t telemetryBuildReply(uint8_t cmd, bool reset, uint8_t *out, size_t cap);
+#else
+static inline uint32_t telemetryMicros() { return 0; }
+static inline void telemetryCount(TelemetryCounter, uint32_t = 1) {}
+static inline void telemetryRecord(TelemetryTiming, uint32_t) {}
+static inline void telemetryNoteSequence(uint8_t, uint16_t) {}
+static inline size_t telemetryBuildReply(uint8_t, bool, uint8_t *, size_t) { return 0; }
+#endif
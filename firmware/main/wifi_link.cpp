@@ -0,0 +1,169 @@
+// wifi_link.cpp
+// Non-blocking Wi-Fi station bring-up and background reconnect
+#include <WiFi.h>
+#include "config.h"
+#include "wifi_link.h"
+#include "network.h"
+#include "persistence.h"
+#include "storage.h"
+#include "telemetry.h"
+#include <atomic>
+#include <string.h>
+
+// The supervisor task owns every WiFi.begin()/disconnect(); Wi-Fi events only record what
+// happened and wake it.
+static TaskHandle_t wifiTaskHandle = nullptr;
+static std::atomic<bool> linkUp(false);
+static std::atomic<uint32_t> disconnects(0);
+
+enum LinkState { LINK_CONNECTING, LINK_UP, LINK_BACKOFF };
+
+// wifiTask only.
+static WifiCache cache;
+static bool haveCache = false;
+static bool tryCache = false; // current attempt uses the cache
+static unsigned long attemptMs = 0;
+static unsigned long deadlineMs = 0;
+
+static uint32_t ssidHash() {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (const char *c = WIFI_SSID; *c; ++c) h = (h ^ uint8_t(*c)) * 16777619u;
+    return h;
+}
+
+static void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            linkUp.store(true);
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            linkUp.store(false);
+            // Our own disconnect() before a retry is not a failed attempt.
+            if (info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE) disconnects.fetch_add(1);
+            break;
+        default:
+            return;
+    }
+    if (wifiTaskHandle) xTaskNotifyGive(wifiTaskHandle);
+}
+
+// Cached: straight to the known BSSID/channel with the last lease as a static address (no
+// scan, no DHCP). Otherwise a full scan and DHCP.
+static void startConnect(bool cached) {
+    WiFi.disconnect(false);
+    if (cached) {
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+        WiFi.begin(WIFI_SSID, WIFI_PASS, cache.channel, cache.bssid);
+    } else {
+        const IPAddress dhcp(uint32_t(0));
+        WiFi.config(dhcp, dhcp, dhcp);
+        WiFi.begin(WIFI_SSID, WIFI_PASS);
+    }
+}
+
+// Store the association just made if it differs from the cache (BSSID, channel or lease).
+static void refreshCache() {
+    WifiCache now;
+    memset(&now, 0, sizeof(now));
+    now.ssidHash = ssidHash();
+    memcpy(now.bssid, WiFi.BSSID(), sizeof(now.bssid));
+    now.channel = uint8_t(WiFi.channel());
+    now.ip = uint32_t(WiFi.localIP());
+    now.gateway = uint32_t(WiFi.gatewayIP());
+    now.subnet = uint32_t(WiFi.subnetMask());
+    now.dns = uint32_t(WiFi.dnsIP(0));
+    if (haveCache && memcmp(&now, &cache, sizeof(now)) == 0) return;
+    cache = now;
+    haveCache = true;
+    persistWifiCache(&cache); // the flash write happens on the persistence task
+}
+
+static void beginAttempt(unsigned long nowMs, bool cached) {
+    tryCache = cached;
+    attemptMs = nowMs;
+    deadlineMs = nowMs + (cached ? WIFI_FAST_CONNECT_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS);
+    startConnect(cached);
+}
+
+static void wifiTask(void * /*arg*/) {
+#if ENABLE_WIFI_FAST_CONNECT
+    haveCache = loadWifiCache(cache) && cache.ssidHash == ssidHash();
+#endif
+    unsigned long backoffMs = WIFI_RECONNECT_MIN_MS;
+    uint32_t disconnectsSeen = disconnects.load();
+    LinkState state = LINK_CONNECTING;
+    Serial.printf("[WiFi] Connecting to %s (%s)\n", WIFI_SSID, haveCache ? "cached AP" : "scan");
+    beginAttempt(millis(), haveCache);
+
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (state != LINK_UP) {
+            long left = long(deadlineMs - millis());
+            wait = left > 0 ? pdMS_TO_TICKS(left) : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+        const unsigned long nowMs = millis();
+        const uint32_t seen = disconnects.load();
+        const bool dropped = seen != disconnectsSeen;
+        disconnectsSeen = seen;
+
+        switch (state) {
+            case LINK_CONNECTING:
+                if (linkUp.load()) {
+                    state = LINK_UP;
+                    backoffMs = WIFI_RECONNECT_MIN_MS;
+                    Serial.printf("[WiFi] Connected in %lu ms, IP %s, channel %d\n", nowMs - attemptMs,
+                                  WiFi.localIP().toString().c_str(), int(WiFi.channel()));
+#if ENABLE_WIFI_FAST_CONNECT
+                    refreshCache();
+#endif
+                    networkLinkUp();
+                } else if (dropped || long(nowMs - deadlineMs) >= 0) {
+                    if (tryCache) {
+                        // AP moved or the lease is gone: scan and ask DHCP right away, and
+                        // drop the stale cache so later attempts and boots don't retry it.
+                        Serial.println("[WiFi] Cached AP failed, scanning");
+                        haveCache = false;
+                        persistWifiCache(nullptr);
+                        beginAttempt(nowMs, false);
+                    } else {
+                        WiFi.disconnect(false);
+                        state = LINK_BACKOFF;
+                        deadlineMs = nowMs + backoffMs;
+                        backoffMs = backoffMs * 2 > WIFI_RECONNECT_MAX_MS ? WIFI_RECONNECT_MAX_MS : backoffMs * 2;
+                    }
+                }
+                break;
+            case LINK_UP:
+                if (!linkUp.load()) {
+                    // Power blip or roam: the cached AP is the one we just lost, retry it first.
+                    Serial.println("[WiFi] Link lost, reconnecting");
+                    telemetryCount(COUNTER_WIFI_RECONNECTS);
+                    state = LINK_CONNECTING;
+                    beginAttempt(nowMs, haveCache);
+                }
+                break;
+            case LINK_BACKOFF:
+                if (long(nowMs - deadlineMs) >= 0) {
+                    state = LINK_CONNECTING;
+                    beginAttempt(nowMs, haveCache);
+                }
+                break;
+        }
+    }
+}
+
+void setupWiFi() {
+    WiFi.persistent(false);       // credentials come from config.h; don't rewrite flash on every begin()
+    WiFi.mode(WIFI_STA);
+    // Disable modem sleep for more reliable UDP receive
+    WiFi.setSleep(false);
+    WiFi.setAutoReconnect(false); // wifiTask reconnects, cached AP first
+    WiFi.onEvent(onWiFiEvent);
+    xTaskCreatePinnedToCore(wifiTask, "wifi", WIFI_TASK_STACK, nullptr, WIFI_TASK_PRIORITY,
+                            &wifiTaskHandle, WIFI_TASK_CORE);
+}
+
+bool wifiConnected() {
+    return linkUp.load();
+}
@@ -0,0 +1,11 @@
+// wifi_link.h
+// Non-blocking Wi-Fi station bring-up and background reconnect
+#pragma once
+
+// Start connecting and return at once. A supervisor task on WIFI_TASK_CORE tries the cached
+// AP (BSSID, channel and address from NVS) first, falls back to a full scan with DHCP, and
+// reconnects with backoff whenever the link drops. The LEDs render the fallback meanwhile.
+void setupWiFi();
+
+// True while the station has an IP address.
+bool wifiConnected();
@@ -0,0 +1,51 @@
+// zones.cpp
+// Zone -> LED blend table and per-frame zone color expansion
+#include "config.h"
+#include "state.h"
+#include "zones.h"
+
+// For each LED: the zone to its left and the Q8 weight (0..255) of the zone to its right.
+// Rebuilt only when the sender changes its zone count.
+struct ZoneBlend {
+    uint8_t lo;
+    uint8_t w;
+};
+
+static ZoneBlend blendTable[NUM_LEDS];
+static uint8_t blendTableZones = 0;
+static CRGB zoneBase[NUM_LEDS];
+
+static void buildBlendTable(uint8_t zoneCount) {
+    // Zone k is centered on LED (k + 0.5) * NUM_LEDS / zoneCount; LEDs outside the first and
+    // last centers hold the edge color.
+    for (int i = 0; i < NUM_LEDS; ++i) {
+        float t = (i + 0.5f) * zoneCount / float(NUM_LEDS) - 0.5f;
+        if (t <= 0.0f) {
+            blendTable[i] = {0, 0};
+        } else if (t >= zoneCount - 1) {
+            blendTable[i] = {uint8_t(zoneCount - 1), 0};
+        } else {
+            int lo = int(t);
+            blendTable[i] = {uint8_t(lo), uint8_t((t - lo) * 255.0f)};
+        }
+    }
+    blendTableZones = zoneCount;
+}
+
+const CRGB *expandZoneColors(const RenderState &rs) {
+    const uint8_t count = rs.zone_count;
+    if (count == 0) return nullptr;
+    if (count != blendTableZones) buildBlendTable(count);
+
+    for (int i = 0; i < NUM_LEDS; ++i) {
+        const ZoneBlend b = blendTable[i];
+        const uint8_t *lo = rs.zones[b.lo];
+        if (b.w == 0) {
+            zoneBase[i] = CRGB(lo[0], lo[1], lo[2]);
+            continue;
+        }
+        const uint8_t *hi = rs.zones[b.lo + 1];
+        zoneBase[i] = CRGB(blend8(lo[0], hi[0], b.w), blend8(lo[1], hi[1], b.w), blend8(lo[2], hi[2], b.w));
+    }
+    return zoneBase;
+}
@@ -0,0 +1,9 @@
+// zones.h
+// Per-LED base colors expanded from the v2 zone payload
+#pragma once
+#include <FastLED.h>
+#include "state.h"
+
+// Expand the state's zone colors into one base color per LED, blending linearly between
+// neighbouring zone centers. Returns nullptr when the frame has a single global color.
+const CRGB *expandZoneColors(const RenderState &rs);
@@ -0,0 +1,70 @@
+"""capture_device.py
+
+Records what an ESP32 actually receives: asks the unit to mirror every incoming packet
+(control command CONTROL_CMD_CAPTURE) and writes them, stamped with the ESP32 arrival
+time, to an ALCAP1 capture for firmware/host replay.
+
+Usage:
+  python tools/capture_device.py 192.168.1.50 --out session.alcap --seconds 600
+"""
+
+import argparse
+import os
+import socket
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'ambient_lighting')))
+
+from capture import CaptureWriter
+
+CONTROL_MAGIC = 0xA6
+CONTROL_REPLY = 0x80
+CONTROL_CMD_CAPTURE = 0x02
+MIRROR_HEADER = 7
+LEASE_RENEW_S = 3.0  # firmware lease is CAPTURE_LEASE_MS (10 s)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    parser.add_argument('host')
+    parser.add_argument('--port', type=int, default=4210)
+    parser.add_argument('--out', required=True)
+    parser.add_argument('--seconds', type=float, default=60.0)
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(0.5)
+    writer = CaptureWriter(args.out)
+    first_ms = None
+    count = 0
+    start = time.monotonic()
+    last_renew = 0.0
+    try:
+        while time.monotonic() - start < args.seconds:
+            now = time.monotonic()
+            if now - last_renew > LEASE_RENEW_S:
+                sock.sendto(bytes([CONTROL_MAGIC, CONTROL_CMD_CAPTURE, 0x01]), (args.host, args.port))
+                last_renew = now
+            try:
+                data, _ = sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            if len(data) <= MIRROR_HEADER or data[0] != CONTROL_MAGIC or data[1] != (CONTROL_CMD_CAPTURE | CONTROL_REPLY):
+                continue  # lease acks and anything unrelated
+            arrival_ms, = struct.unpack_from('<I', data, 3)
+            if first_ms is None:
+                first_ms = arrival_ms
+            writer.write(data[MIRROR_HEADER:], t_ms=(arrival_ms - first_ms) & 0xFFFFFFFF, channel=data[2])
+            count += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.sendto(bytes([CONTROL_MAGIC, CONTROL_CMD_CAPTURE, 0x00]), (args.host, args.port))
+        writer.close()
+    print(f"captured {count} packets to {args.out}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,55 @@
+"""poll_device_stats.py
+
+Polls one or more ESP32 units for their on-device telemetry (stage timings and packet
+counters) and prints one line per unit, or JSON with --json.
+
+Usage:
+  python tools/poll_device_stats.py 192.168.1.50 192.168.1.51 --interval 2 --reset
+"""
+
+import argparse
+import json
+import os
+import sys
+import time
+
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'ambient_lighting')))
+
+from telemetry_client import poll_stats
+
+
+def _format(ip, stats):
+    c = stats['counters']
+    parts = [f"{ip} up={stats['uptime_ms'] / 1000:.0f}s ok={c.get('packets_ok', 0)} "
+             f"lost={c.get('lost', 0)} reord={c.get('reordered', 0)} crc={c.get('bad_checksum', 0)} "
+             f"conceal={c.get('concealed', 0)} late={c.get('late_dropped', 0)}"]
+    for name, t in stats['timings'].items():
+        parts.append(f"{name}={t['avg_us']}/{t['p99_us']}/{t['max_us']}us")
+    return ' '.join(parts)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    parser.add_argument('hosts', nargs='+')
+    parser.add_argument('--port', type=int, default=4210)
+    parser.add_argument('--interval', type=float, default=0.0, help='repeat every N seconds (0 = once)')
+    parser.add_argument('--reset', action='store_true', help='zero counters after each read')
+    parser.add_argument('--json', action='store_true')
+    args = parser.parse_args()
+
+    while True:
+        for ip in args.hosts:
+            stats = poll_stats(ip, args.port, reset=args.reset)
+            if stats is None:
+                print(f"{ip} no reply")
+            elif args.json:
+                print(json.dumps({'host': ip, **stats}))
+            else:
+                print(_format(ip, stats))
+        if args.interval <= 0:
+            break
+        time.sleep(args.interval)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,55 @@
+"""upload_color_lut.py
+
+Builds a gamma/white-balance LUT and loads it into one strip segment of an ESP32 unit,
+optionally storing it in NVS. Use it to match separately powered strip batches.
+
+Usage:
+  python tools/upload_color_lut.py 192.168.1.50 --segment 1 --gamma 2.2 --white 255,190,220 --persist
+  python tools/upload_color_lut.py 192.168.1.50 --segment 1 --file batch_b.lut --persist
+  python tools/upload_color_lut.py 192.168.1.50 --segment 1 --default --persist
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'ambient_lighting')))
+
+from color_lut_client import COLOR_LUT_BYTES, LUT_BAD, LUT_BUSY, LUT_OK, build_lut, upload_lut
+
+
+def _parse_white(text):
+    parts = [int(p) for p in text.split(',')]
+    if len(parts) != 3 or any(p < 0 or p > 255 for p in parts):
+        raise argparse.ArgumentTypeError('expected R,G,B in 0..255')
+    return tuple(parts)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    parser.add_argument('host')
+    parser.add_argument('--port', type=int, default=4210)
+    parser.add_argument('--segment', type=int, default=0)
+    parser.add_argument('--gamma', type=float, default=2.2)
+    parser.add_argument('--white', type=_parse_white, default=(255, 255, 255), help='white point R,G,B')
+    parser.add_argument('--file', help='raw %d-byte table (256 R, 256 G, 256 B) instead of --gamma/--white'
+                        % COLOR_LUT_BYTES)
+    parser.add_argument('--default', action='store_true', help='restore the built-in firmware table')
+    parser.add_argument('--persist', action='store_true', help='store in NVS (or erase it with --default)')
+    args = parser.parse_args()
+
+    table = None
+    if args.file:
+        with open(args.file, 'rb') as f:
+            table = f.read()
+    elif not args.default:
+        table = build_lut(args.gamma, args.white)
+
+    status = upload_lut(args.host, args.port, args.segment, table, persist=args.persist)
+    messages = {LUT_OK: 'ok', LUT_BAD: 'rejected (size, CRC or segment)', LUT_BUSY: 'busy'}
+    print(f"{args.host} segment {args.segment}: {messages.get(status, 'no reply')}")
+    sys.exit(0 if status == LUT_OK else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,60 @@
+"""upload_scene.py
+
+Loads a scene into the on-device scene engine of an ESP32 unit (what it shows while no laptop
+is sending), optionally storing it in NVS. One scene per call; --select switches between the
+scenes already installed.
+
+Usage:
+  python tools/upload_scene.py 192.168.1.50 --effect noise --color1 255,120,40 --color2 120,20,60 --persist
+  python tools/upload_scene.py 192.168.1.50 --effect sunrise --color1 60,10,0 --color2 255,200,140 --minutes 20
+  python tools/upload_scene.py 192.168.1.50 --effect breathe --last-color --persist
+  python tools/upload_scene.py 192.168.1.50 --select 0
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'ambient_lighting')))
+
+from scene_client import EFFECTS, SCENE_BAD, SCENE_BUSY, SCENE_OK, build_scene_record, upload_scenes
+
+
+def _parse_color(text):
+    parts = [int(p) for p in text.split(',')]
+    if len(parts) != 3 or any(p < 0 or p > 255 for p in parts):
+        raise argparse.ArgumentTypeError('expected R,G,B in 0..255')
+    return tuple(parts)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    parser.add_argument('host')
+    parser.add_argument('--port', type=int, default=4210)
+    parser.add_argument('--effect', choices=sorted(EFFECTS), default='breathe')
+    parser.add_argument('--color1', type=_parse_color, default=(255, 180, 80))
+    parser.add_argument('--color2', type=_parse_color, default=(255, 90, 20))
+    parser.add_argument('--brightness', type=int, default=110)
+    parser.add_argument('--speed', type=int, default=21, help='time step, 1/16 per ms (21 = ~50 s breathing cycle)')
+    parser.add_argument('--scale', type=int, default=16, help='spatial step of noise/gradient')
+    parser.add_argument('--minutes', type=int, default=30, help='sunrise length')
+    parser.add_argument('--last-color', action='store_true', help='color1/brightness from the last laptop scene')
+    parser.add_argument('--select', type=int, help='only make installed scene N active')
+    parser.add_argument('--persist', action='store_true', help='store in NVS')
+    args = parser.parse_args()
+
+    if args.select is not None:
+        records, active = [], args.select
+    else:
+        records = [build_scene_record(args.effect, args.color1, args.color2, args.brightness, args.speed,
+                                      args.scale, args.minutes, last_color=args.last_color)]
+        active = 0
+
+    status = upload_scenes(args.host, args.port, records, active, persist=args.persist)
+    messages = {SCENE_OK: 'ok', SCENE_BAD: 'rejected (size, CRC or record)', SCENE_BUSY: 'busy'}
+    print(f"{args.host} scenes: {messages.get(status, 'no reply')}")
+    sys.exit(0 if status == SCENE_OK else 1)
+
+
+if __name__ == '__main__':
+    main()